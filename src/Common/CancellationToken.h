@@ -0,0 +1,30 @@
+#pragma once
+
+#include <atomic>
+
+/**
+ * CancellationToken
+ *
+ * Thread-safe request to stop a long computation. Computations poll the token at block granularity,
+ * e.g. per block of a parallel loop, and return early with an incomplete result; the caller checks the
+ * token again to discard that result.
+ */
+class CancellationToken
+{
+public:
+    CancellationToken() :
+        _cancelled(false)
+    {
+    }
+
+    /** Request the computation to stop, may be called from any thread */
+    void cancel() { _cancelled.store(true, std::memory_order_relaxed); }
+
+    /** Clear the request before starting another computation */
+    void reset() { _cancelled.store(false, std::memory_order_relaxed); }
+
+    bool isCancelled() const { return _cancelled.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool>   _cancelled;     /** Whether a stop was requested */
+};
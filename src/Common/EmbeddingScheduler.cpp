@@ -0,0 +1,235 @@
+#include "EmbeddingScheduler.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+    // Upper limit of concurrently running embedding jobs, further jobs are queued
+    constexpr std::uint32_t _MAX_CONCURRENT_JOBS_ = 4;
+
+    // Time given to running jobs to return when the application shuts down
+    constexpr unsigned long _SHUTDOWN_WAIT_MS_ = 500;
+
+    // Heap order: higher priority first, equal priorities in submission order
+    template <typename QueuedJob>
+    bool runsLater(const QueuedJob& lhs, const QueuedJob& rhs)
+    {
+        if (lhs.job.priority != rhs.job.priority)
+            return lhs.job.priority < rhs.job.priority;
+
+        return lhs.sequence > rhs.sequence;
+    }
+}
+
+EmbeddingScheduler& EmbeddingScheduler::instance()
+{
+    // Created in the UI thread on first use, the application deletes it on shutdown
+    static EmbeddingScheduler* scheduler = new EmbeddingScheduler(QCoreApplication::instance());
+    return *scheduler;
+}
+
+EmbeddingScheduler::EmbeddingScheduler(QObject* parent) :
+    QObject(parent),
+    _queue(),
+    _workers(),
+    _nextJobId(1),
+    _nextSequence(0),
+    _numRunningJobs(0),
+    _numCores(static_cast<std::uint32_t>(std::max(1, QThread::idealThreadCount())))
+{
+    // Leave half of the cores for data loading, rendering etc. unless the machine is small
+    const auto numWorkers = std::clamp<std::uint32_t>(_numCores / 2, 1, _MAX_CONCURRENT_JOBS_);
+
+    _workers.resize(numWorkers);
+
+    for (std::size_t workerIndex = 0; workerIndex < _workers.size(); workerIndex++)
+    {
+        auto& worker = _workers[workerIndex];
+
+        worker.thread = new QThread();
+        worker.thread->setObjectName(QString("Embedding worker %1").arg(workerIndex));
+        worker.context = new QObject();
+        worker.context->moveToThread(worker.thread);
+        worker.jobId = 0;
+        worker.busy = false;
+
+        connect(worker.thread, &QThread::finished, worker.context, &QObject::deleteLater);
+
+        worker.thread->start();
+    }
+
+    qDebug() << "EmbeddingScheduler: " << numWorkers << " workers sharing " << _numCores << " cores";
+}
+
+EmbeddingScheduler::~EmbeddingScheduler()
+{
+    for (auto& queuedJob : _queue)
+        disconnect(queuedJob.abortConnection);
+
+    _queue.clear();
+
+    for (auto& worker : _workers)
+    {
+        worker.thread->quit();                          // Signal the thread to quit gracefully
+        if (!worker.thread->wait(_SHUTDOWN_WAIT_MS_))   // Wait for the thread to actually finish
+            worker.thread->terminate();                 // Terminate thread after 0.5 seconds
+
+        delete worker.thread;
+    }
+}
+
+EmbeddingScheduler::JobId EmbeddingScheduler::submit(EmbeddingJob job)
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+
+    QueuedJob queuedJob;
+    queuedJob.id = _nextJobId++;
+    queuedJob.sequence = _nextSequence++;
+
+    // Abort requests for queued jobs are handled here, running jobs react to them by themselves
+    if (job.task)
+        queuedJob.abortConnection = connect(job.task, &mv::Task::requestAbort, this, [this, jobId = queuedJob.id]() -> void {
+            cancel(jobId);
+        });
+
+    queuedJob.job = std::move(job);
+
+    const auto jobId = queuedJob.id;
+
+    _queue.push_back(std::move(queuedJob));
+    std::push_heap(_queue.begin(), _queue.end(), runsLater<QueuedJob>);
+
+    dispatch();
+
+    return jobId;
+}
+
+bool EmbeddingScheduler::cancel(JobId jobId)
+{
+    const auto it = std::find_if(_queue.begin(), _queue.end(), [jobId](const QueuedJob& queuedJob) { return queuedJob.id == jobId; });
+
+    if (it == _queue.end())
+        return false;
+
+    QueuedJob queuedJob = std::move(*it);
+    _queue.erase(it);
+    std::make_heap(_queue.begin(), _queue.end(), runsLater<QueuedJob>);
+
+    disconnect(queuedJob.abortConnection);
+
+    if (queuedJob.job.context && queuedJob.job.cancelled)
+        queuedJob.job.cancelled();
+
+    emit jobCancelled(jobId);
+
+    return true;
+}
+
+bool EmbeddingScheduler::isQueued(JobId jobId) const
+{
+    return std::any_of(_queue.begin(), _queue.end(), [jobId](const QueuedJob& queuedJob) { return queuedJob.id == jobId; });
+}
+
+bool EmbeddingScheduler::isRunning(JobId jobId) const
+{
+    return std::any_of(_workers.begin(), _workers.end(), [jobId](const Worker& worker) { return worker.busy && worker.jobId == jobId; });
+}
+
+void EmbeddingScheduler::wait(JobId jobId) const
+{
+    const auto it = std::find_if(_workers.begin(), _workers.end(), [jobId](const Worker& worker) { return worker.busy && worker.jobId == jobId; });
+
+    if (it == _workers.end())
+        return;
+
+    // The worker entry itself is only reset once the finish notification is processed in this thread
+    it->done.wait();
+}
+
+void EmbeddingScheduler::applyThreadShare() const
+{
+#ifdef _OPENMP
+    const std::uint32_t numRunningJobs = std::max<std::uint32_t>(1, _numRunningJobs.load());
+    omp_set_num_threads(static_cast<int>(std::max<std::uint32_t>(1, _numCores / numRunningJobs)));
+#endif
+}
+
+void EmbeddingScheduler::dispatch()
+{
+    for (std::size_t workerIndex = 0; workerIndex < _workers.size() && !_queue.empty(); workerIndex++)
+    {
+        auto& worker = _workers[workerIndex];
+
+        if (worker.busy)
+            continue;
+
+        // Find the next job whose owner still exists
+        QueuedJob queuedJob;
+        bool found = false;
+
+        while (!_queue.empty() && !found)
+        {
+            std::pop_heap(_queue.begin(), _queue.end(), runsLater<QueuedJob>);
+            queuedJob = std::move(_queue.back());
+            _queue.pop_back();
+
+            disconnect(queuedJob.abortConnection);
+
+            found = !queuedJob.job.context.isNull();
+        }
+
+        if (!found)
+            break;
+
+        if (queuedJob.job.prepare)
+            queuedJob.job.prepare(worker.thread);
+
+        auto promise = std::make_shared<std::promise<void>>();
+
+        worker.busy = true;
+        worker.jobId = queuedJob.id;
+        worker.done = promise->get_future().share();
+
+        _numRunningJobs++;
+
+        QMetaObject::invokeMethod(worker.context, [this, workerIndex, promise, run = std::move(queuedJob.job.run)]() -> void {
+            applyThreadShare();
+
+            if (run)
+                run();
+
+            // Release the core share right away, the bookkeeping below waits for the scheduler thread
+            _numRunningJobs--;
+            promise->set_value();
+
+            QMetaObject::invokeMethod(this, [this, workerIndex]() -> void {
+                onJobFinished(workerIndex);
+            }, Qt::QueuedConnection);
+        }, Qt::QueuedConnection);
+
+        emit jobStarted(queuedJob.id);
+    }
+}
+
+void EmbeddingScheduler::onJobFinished(std::size_t workerIndex)
+{
+    auto& worker = _workers[workerIndex];
+
+    const auto jobId = worker.jobId;
+
+    worker.busy = false;
+    worker.jobId = 0;
+    worker.done = {};
+
+    emit jobFinished(jobId);
+
+    dispatch();
+}
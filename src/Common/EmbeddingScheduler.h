@@ -0,0 +1,123 @@
+#pragma once
+
+#include <Task.h>
+
+#include <QMetaObject>
+#include <QObject>
+#include <QPointer>
+#include <QThread>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <vector>
+
+/**
+ * EmbeddingJob
+ *
+ * A unit of work for the embedding scheduler, e.g. the similarity computation and gradient descent of a single t-SNE analysis
+ */
+struct EmbeddingJob
+{
+    QPointer<QObject>               context;            /** Job is dropped if the context is destroyed before the job started */
+    std::function<void(QThread*)>   prepare;            /** Called in the scheduler thread right before run, with the pool thread that will execute the job */
+    std::function<void()>           run;                /** Executed in a pool thread */
+    std::function<void()>           cancelled;          /** Called in the scheduler thread if the job is cancelled before it started */
+    int                             priority = 0;       /** Jobs with a higher priority are started first, equal priorities in submission order */
+    mv::Task*                       task = nullptr;     /** Aborting this task cancels the job while it is queued */
+};
+
+/**
+ * EmbeddingScheduler
+ *
+ * Process-wide scheduler for embedding computations. Jobs of all analyses (t-SNE, HSNE scales and their refinements)
+ * are queued by priority and executed on a fixed pool of worker threads, instead of every analysis running its own thread.
+ *
+ * Running jobs share the cores: every job should call applyThreadShare() regularly (e.g. once per gradient descent iteration),
+ * which limits its OpenMP team to an equal share of the hardware threads.
+ */
+class EmbeddingScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    using JobId = std::uint64_t;
+
+    /** Scheduler instance, created on first use and owned by the application */
+    static EmbeddingScheduler& instance();
+
+    /**
+     * Queue a job, it is started as soon as a pool thread is free and no job with a higher priority is waiting
+     * @param job Job description
+     * @return Identifier of the job, used for cancel() and wait()
+     */
+    JobId submit(EmbeddingJob job);
+
+    /**
+     * Remove a job from the queue, running jobs are not affected and must be stopped by their owner
+     * @param jobId Job identifier
+     * @return Whether the job was still queued
+     */
+    bool cancel(JobId jobId);
+
+    /** Whether the job is waiting for a free pool thread */
+    bool isQueued(JobId jobId) const;
+
+    /** Whether the job is currently executed by a pool thread */
+    bool isRunning(JobId jobId) const;
+
+    /**
+     * Block until a running job returned, without processing events: callers may be destructors or slots.
+     * Jobs must not depend on events of the calling thread, stop the job before waiting for it
+     */
+    void wait(JobId jobId) const;
+
+    /** Limit the OpenMP threads of the calling pool thread to its share of the cores */
+    void applyThreadShare() const;
+
+    std::uint32_t getNumWorkers() const { return static_cast<std::uint32_t>(_workers.size()); }
+    std::uint32_t getNumRunningJobs() const { return _numRunningJobs.load(); }
+    std::uint32_t getNumQueuedJobs() const { return static_cast<std::uint32_t>(_queue.size()); }
+
+signals:
+    void jobStarted(JobId jobId);
+    void jobFinished(JobId jobId);
+    void jobCancelled(JobId jobId);
+
+private:
+    EmbeddingScheduler(QObject* parent);
+    ~EmbeddingScheduler() override;
+
+    /** Start queued jobs on idle workers */
+    void dispatch();
+
+    /** Called in the scheduler thread when a worker returned from a job */
+    void onJobFinished(std::size_t workerIndex);
+
+private:
+    struct QueuedJob
+    {
+        JobId                       id;
+        std::uint64_t               sequence;
+        EmbeddingJob                job;
+        QMetaObject::Connection     abortConnection;
+    };
+
+    struct Worker
+    {
+        QThread*                    thread;
+        QObject*                    context;            /** Lives in thread, queued invocations on it execute there */
+        JobId                       jobId;
+        std::shared_future<void>    done;
+        bool                        busy;
+    };
+
+private:
+    std::vector<QueuedJob>          _queue;             /** Waiting jobs, a heap ordered by priority and sequence */
+    std::vector<Worker>             _workers;           /** Fixed pool of worker threads */
+    JobId                           _nextJobId;         /** Identifier of the next submitted job */
+    std::uint64_t                   _nextSequence;      /** Tie-breaker that keeps equal priorities in submission order */
+    std::atomic<std::uint32_t>      _numRunningJobs;    /** Number of jobs currently executed */
+    std::uint32_t                   _numCores;          /** Number of hardware threads shared by the running jobs */
+};
@@ -0,0 +1,135 @@
+#include "GradientDescentProgress.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Weight of the latest measurement in the smoothed iteration rate
+    constexpr double _RATE_SMOOTHING_ = 0.3;
+
+    QString formatDuration(double seconds)
+    {
+        const auto total = static_cast<long long>(std::ceil(seconds));
+
+        if (total >= 3600)
+            return QString("%1 h %2 min").arg(total / 3600).arg((total % 3600) / 60);
+
+        if (total >= 60)
+            return QString("%1 min %2 s").arg(total / 60).arg(total % 60);
+
+        return QString("%1 s").arg(total);
+    }
+}
+
+GradientDescentProgress::GradientDescentProgress(std::uint32_t maxSubtasks) :
+    _maxSubtasks(std::max<std::uint32_t>(1, maxSubtasks)),
+    _task(nullptr),
+    _chunks(),
+    _currentChunk(0),
+    _endIteration(0),
+    _lastIteration(0),
+    _lastUpdate(),
+    _iterationsPerSecond(0)
+{
+}
+
+std::vector<GradientDescentProgress::Chunk> GradientDescentProgress::makeChunks(int beginIteration, int endIteration, int exaggerationEnd, int decayEnd, std::uint32_t maxChunks)
+{
+    struct Phase
+    {
+        const char* name;
+        int         begin;
+        int         end;
+    };
+
+    // Phases clipped to the iterations, a continued computation may start after the exaggeration
+    std::vector<Phase> phases;
+    for (const auto& phase : { Phase{ "Exaggeration", 0, exaggerationEnd }, Phase{ "Exaggeration decay", exaggerationEnd, decayEnd }, Phase{ "Refinement", decayEnd, endIteration } })
+    {
+        const auto begin = std::max(phase.begin, beginIteration);
+        const auto end = std::min(phase.end, endIteration);
+
+        if (begin < end)
+            phases.push_back({ phase.name, begin, end });
+    }
+
+    std::vector<Chunk> chunks;
+
+    if (phases.empty())
+        return chunks;
+
+    const auto numIterations = static_cast<std::int64_t>(endIteration - beginIteration);
+    const auto numShared = static_cast<std::int64_t>(std::max<std::size_t>(maxChunks, phases.size()) - phases.size());
+
+    // One chunk per phase and the others in proportion to the iterations, which sums to at most max(maxChunks, number of phases)
+    for (const auto& phase : phases)
+    {
+        const std::int64_t numPhaseIterations = phase.end - phase.begin;
+        const std::int64_t numChunks = std::min(numPhaseIterations, 1 + numShared * numPhaseIterations / numIterations);
+
+        for (std::int64_t chunk = 0; chunk < numChunks; chunk++)
+        {
+            const auto begin = static_cast<int>(phase.begin + numPhaseIterations * chunk / numChunks);
+            const auto end = static_cast<int>(phase.begin + numPhaseIterations * (chunk + 1) / numChunks);
+
+            chunks.push_back({ QString("%1: iterations %2 - %3").arg(phase.name).arg(begin).arg(end - 1), begin, end });
+        }
+    }
+
+    return chunks;
+}
+
+void GradientDescentProgress::start(mv::Task& task, int beginIteration, int endIteration, int exaggerationEnd, int decayEnd)
+{
+    _task = &task;
+    _chunks = makeChunks(beginIteration, endIteration, exaggerationEnd, decayEnd, _maxSubtasks);
+    _currentChunk = 0;
+    _endIteration = endIteration;
+    _lastIteration = beginIteration - 1;
+    _lastUpdate = Clock::now();
+    _iterationsPerSecond = 0;
+
+    if (_chunks.empty())
+        return;
+
+    QStringList names;
+    for (const auto& chunk : _chunks)
+        names << chunk.name;
+
+    _task->setSubtasks(names);
+    _task->setSubtaskStarted(0);
+}
+
+void GradientDescentProgress::update(int iteration)
+{
+    if (!_task || _chunks.empty() || iteration <= _lastIteration)
+        return;
+
+    const auto now = Clock::now();
+    const auto seconds = std::chrono::duration<double>(now - _lastUpdate).count();
+
+    if (seconds > 0)
+    {
+        const auto rate = (iteration - _lastIteration) / seconds;
+        _iterationsPerSecond = _iterationsPerSecond > 0 ? (1 - _RATE_SMOOTHING_) * _iterationsPerSecond + _RATE_SMOOTHING_ * rate : rate;
+    }
+
+    _lastIteration = iteration;
+    _lastUpdate = now;
+
+    while (_currentChunk < _chunks.size() && _chunks[_currentChunk].endIteration <= iteration + 1)
+    {
+        _task->setSubtaskFinished(static_cast<std::uint32_t>(_currentChunk));
+
+        if (++_currentChunk < _chunks.size())
+            _task->setSubtaskStarted(static_cast<std::uint32_t>(_currentChunk));
+    }
+
+    if (_currentChunk >= _chunks.size() || _iterationsPerSecond <= 0)
+        return;
+
+    const auto remaining = (_endIteration - 1 - iteration) / _iterationsPerSecond;
+
+    _task->setProgressDescription(QString("%1 (%2 it/s, %3 left)").arg(_chunks[_currentChunk].name).arg(_iterationsPerSecond, 0, 'f', 0).arg(formatDuration(remaining)));
+}
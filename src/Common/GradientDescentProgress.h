@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Task.h>
+
+#include <QString>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * GradientDescentProgress
+ *
+ * Progress of a gradient descent as a bounded number of task subtasks. The iterations are split into the
+ * phases of the optimization (exaggeration, exaggeration decay, refinement) and every phase into chunks,
+ * at most maxSubtasks in total independent of the number of iterations. The progress description shows
+ * the current phase and a remaining time estimated from the measured iterations per second.
+ */
+class GradientDescentProgress
+{
+public:
+    /** Iterations [beginIteration, endIteration) reported as one subtask */
+    struct Chunk
+    {
+        QString     name;               /** Subtask name */
+        int         beginIteration;     /** First iteration of the chunk */
+        int         endIteration;       /** One past the last iteration of the chunk */
+    };
+
+public:
+    /**
+     * Constructor
+     * @param maxSubtasks Maximum number of subtasks
+     */
+    GradientDescentProgress(std::uint32_t maxSubtasks = 64);
+
+    /**
+     * Create the subtasks of the iterations [beginIteration, endIteration) and start the first one
+     * @param task Task that receives the subtasks
+     * @param exaggerationEnd First iteration without full exaggeration
+     * @param decayEnd First iteration without exaggeration
+     */
+    void start(mv::Task& task, int beginIteration, int endIteration, int exaggerationEnd, int decayEnd);
+
+    /** All iterations up to and including the iteration are done, call it at a low cadence */
+    void update(int iteration);
+
+    /** Measured iterations per second, smoothed over the updates */
+    double getIterationsPerSecond() const { return _iterationsPerSecond; }
+
+    /** Split [beginIteration, endIteration) into at most maxChunks chunks, every non-empty phase gets at least one */
+    static std::vector<Chunk> makeChunks(int beginIteration, int endIteration, int exaggerationEnd, int decayEnd, std::uint32_t maxChunks);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::uint32_t           _maxSubtasks;           /** Maximum number of subtasks */
+    mv::Task*               _task;                  /** Task that receives the subtasks */
+    std::vector<Chunk>      _chunks;                /** Chunks of the running gradient descent */
+    std::size_t             _currentChunk;          /** Index of the running chunk */
+    int                     _endIteration;          /** One past the last iteration */
+    int                     _lastIteration;         /** Iteration of the last update */
+    Clock::time_point       _lastUpdate;            /** Time of the last update */
+    double                  _iterationsPerSecond;   /** Smoothed rate, 0 before the first update */
+};
@@ -0,0 +1,92 @@
+#include "KnnSimilarities.h"
+
+#include "hdi/utils/math_utils.h"
+
+#include <flann/flann.hpp>
+
+#include <algorithm>
+
+namespace
+{
+    // Number of points that are queried between two checks of the cancellation token
+    constexpr std::int64_t _KNN_BATCH_SIZE_ = 512;
+
+    // Bisection of the Gaussian bandwidth, the arguments of the HDI probability generator
+    constexpr int _PERPLEXITY_MAX_ITERATIONS_ = 200;
+    constexpr double _PERPLEXITY_TOLERANCE_ = 1e-5;
+}
+
+KnnSimilarities::KnnSimilarities(const KnnParameters& knnParameters, uint32_t numNeighbors, double perplexity) :
+    _knnParameters(knnParameters),
+    _numNeighbors(numNeighbors),
+    _perplexity(perplexity)
+{
+}
+
+bool KnnSimilarities::isSupported(const KnnParameters& knnParameters)
+{
+    return knnParameters.getKnnAlgorithm() == hdi::dr::KNN_FLANN && knnParameters.getKnnDistanceMetric() == hdi::dr::KNN_METRIC_EUCLIDEAN;
+}
+
+bool KnnSimilarities::compute(const float* data, uint32_t numPoints, uint32_t numDimensions, Matrix& distribution, const CancellationToken& cancellation) const
+{
+    distribution.clear();
+    distribution.resize(numPoints);
+
+    if (numPoints == 0 || cancellation.isCancelled())
+        return !cancellation.isCancelled();
+
+    const std::int64_t nn = std::min(_numNeighbors, numPoints);
+
+    // FLANN does not modify the data but does not take a const pointer
+    flann::Matrix<float> dataset(const_cast<float*>(data), numPoints, numDimensions);
+
+    // Same index and search as HDI. Building the randomized kd-trees cannot be interrupted, it takes a fraction of the time of the queries
+    flann::Index<flann::L2<float>> index(dataset, flann::KDTreeIndexParams(_knnParameters.getAnnoyNumTrees()));
+    index.buildIndex();
+
+    flann::SearchParams searchParams(_knnParameters.getAnnoyNumChecks());
+    searchParams.cores = 0;     // all cores
+
+    std::vector<int> indices(_KNN_BATCH_SIZE_ * nn);
+    std::vector<float> distancesSquared(_KNN_BATCH_SIZE_ * nn);
+
+    for (std::int64_t batchBegin = 0; batchBegin < numPoints; batchBegin += _KNN_BATCH_SIZE_)
+    {
+        if (cancellation.isCancelled())
+            return false;
+
+        const std::int64_t batchSize = std::min<std::int64_t>(_KNN_BATCH_SIZE_, numPoints - batchBegin);
+
+        flann::Matrix<float> queries(const_cast<float*>(data) + batchBegin * numDimensions, batchSize, numDimensions);
+        flann::Matrix<int> indicesMatrix(indices.data(), batchSize, nn);
+        flann::Matrix<float> distancesMatrix(distancesSquared.data(), batchSize, nn);
+
+        index.knnSearch(queries, indicesMatrix, distancesMatrix, nn, searchParams);
+
+#pragma omp parallel
+        {
+            std::vector<float> probabilities(nn);
+
+#pragma omp for schedule(dynamic, 16)
+            for (std::int64_t i = 0; i < batchSize; i++)
+            {
+                const auto distancesBegin = distancesSquared.cbegin() + i * nn;
+
+                // The per-row Gaussian of HDI, the first neighbour is the point itself and ignored
+                hdi::utils::computeGaussianDistributionWithFixedPerplexity<std::vector<float>>(distancesBegin, distancesBegin + nn, probabilities.begin(), probabilities.end(), _perplexity, _PERPLEXITY_MAX_ITERATIONS_, _PERPLEXITY_TOLERANCE_, 0);
+
+                const int* rowIndices = indices.data() + i * nn;
+
+                auto& row = distribution[batchBegin + i].memory();
+                row.resize(nn - 1);
+                for (std::int64_t j = 1; j < nn; j++)
+                    row[j - 1] = { static_cast<uint32_t>(rowIndices[j]), probabilities[j] };
+
+                std::sort(row.begin(), row.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+            }
+        }
+    }
+
+    return !cancellation.isCancelled();
+}
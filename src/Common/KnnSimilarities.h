@@ -0,0 +1,58 @@
+#pragma once
+
+#include "CancellationToken.h"
+#include "KnnParameters.h"
+
+#include "hdi/data/map_mem_eff.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * KnnSimilarities
+ *
+ * Conditional probabilities of the nearest neighbours of every point, i.e. the similarities of t-SNE
+ * before symmetrization and the transition matrix of the HSNE data scale. Every row holds the Gaussian
+ * probabilities of the neighbours of a point, with a bandwidth that matches the perplexity.
+ *
+ * Unlike the HDI probability generator, which queries all points in one call, the neighbours are
+ * queried per batch of rows, a stop request takes effect after the current batch. The index and the
+ * search have the parameters of the HDI generator and the probabilities of a row are computed by HDI,
+ * such that the result is the one of the generator.
+ *
+ * Limits: only the Euclidean FLANN search (the default) is queried this way, see isSupported. HNSW,
+ * Annoy and the other metrics are left to HDI and can only be stopped once its search has finished.
+ * Building the FLANN index cannot be interrupted either.
+ */
+class KnnSimilarities
+{
+public:
+    using Matrix = std::vector<hdi::data::MapMemEff<uint32_t, float>>;
+
+    /**
+     * Constructor
+     * @param knnParameters Parameters of the nearest neighbour search
+     * @param numNeighbors Number of neighbours per point, including the point itself
+     * @param perplexity Perplexity of the Gaussian of every point
+     */
+    KnnSimilarities(const KnnParameters& knnParameters, uint32_t numNeighbors, double perplexity);
+
+    /** Whether the neighbours can be queried in batches, other libraries and metrics are left to HDI */
+    static bool isSupported(const KnnParameters& knnParameters);
+
+    /**
+     * Compute the similarities of all points, same as the HDI probability generator
+     * @param data Point-major data, numPoints * numDimensions values
+     * @param numPoints Number of points
+     * @param numDimensions Number of dimensions
+     * @param distribution Receives numPoints rows of at most numNeighbors - 1 entries
+     * @param cancellation Polled per batch of rows
+     * @return Whether all rows were computed, false if the computation was stopped
+     */
+    bool compute(const float* data, uint32_t numPoints, uint32_t numDimensions, Matrix& distribution, const CancellationToken& cancellation) const;
+
+private:
+    KnnParameters   _knnParameters;     /** Parameters of the nearest neighbour search */
+    uint32_t        _numNeighbors;      /** Number of neighbours per point, including the point itself */
+    double          _perplexity;        /** Perplexity of the Gaussian of every point */
+};
@@ -0,0 +1,205 @@
+#include "PhaseProfiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    /** Small, stable id of the calling thread for the trace */
+    std::uint32_t currentThreadId()
+    {
+        static std::atomic<std::uint32_t> nextId{ 1 };
+        thread_local const std::uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    /** Escape a string for a JSON string literal */
+    std::string escapeJson(const std::string& text)
+    {
+        std::string escaped;
+        escaped.reserve(text.size());
+
+        for (const char c : text)
+        {
+            switch (c)
+            {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            default:   escaped += c; break;
+            }
+        }
+
+        return escaped;
+    }
+}
+
+PhaseProfiler::PhaseProfiler(const std::string& name, std::size_t capacity) :
+    _name(name),
+    _origin(Clock::now()),
+    _phaseNames(),
+    _counters(),
+    _events(std::max<std::size_t>(1, capacity)),
+    _numEvents(0)
+{
+}
+
+PhaseProfiler::PhaseProfiler(const std::string& name, const std::vector<std::string>& phases, std::size_t capacity) :
+    PhaseProfiler(name, capacity)
+{
+    for (const auto& phase : phases)
+        addPhase(phase);
+}
+
+PhaseProfiler::PhaseId PhaseProfiler::addPhase(const std::string& name)
+{
+    _phaseNames.push_back(name);
+    _counters.push_back(std::make_unique<Counters>());
+
+    return static_cast<PhaseId>(_phaseNames.size() - 1);
+}
+
+void PhaseProfiler::record(PhaseId phase, Clock::time_point start, Clock::time_point end)
+{
+    assert(phase < _counters.size());
+
+    const auto durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    auto& counters = *_counters[phase];
+
+    counters.count.fetch_add(1, std::memory_order_relaxed);
+    counters.totalNs.fetch_add(durationNs, std::memory_order_relaxed);
+
+    auto maxNs = counters.maxNs.load(std::memory_order_relaxed);
+    while (durationNs > maxNs && !counters.maxNs.compare_exchange_weak(maxNs, durationNs, std::memory_order_relaxed));
+
+    const auto index = _numEvents.fetch_add(1, std::memory_order_relaxed);
+    auto& slot = _events[index % _events.size()];
+
+    // Odd while the fields are written, readers skip the slot until the final sequence number is published
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.phase.store(phase, std::memory_order_relaxed);
+    slot.thread.store(currentThreadId(), std::memory_order_relaxed);
+    slot.startNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(start - _origin).count(), std::memory_order_relaxed);
+    slot.durationNs.store(durationNs, std::memory_order_relaxed);
+
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+bool PhaseProfiler::readEvent(std::uint64_t index, Event& event) const
+{
+    const auto& slot = _events[index % _events.size()];
+
+    const auto sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != 2 * index + 2)
+        return false;
+
+    event.phase = slot.phase.load(std::memory_order_relaxed);
+    event.thread = slot.thread.load(std::memory_order_relaxed);
+    event.startNs = slot.startNs.load(std::memory_order_relaxed);
+    event.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+
+    // The event is consistent if no writer started on the slot in the meantime
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+void PhaseProfiler::reset()
+{
+    _origin = Clock::now();
+    _numEvents = 0;
+
+    for (auto& slot : _events)
+        slot.sequence = 0;
+
+    for (auto& counters : _counters)
+    {
+        counters->count = 0;
+        counters->totalNs = 0;
+        counters->maxNs = 0;
+    }
+}
+
+std::vector<PhaseProfiler::PhaseSummary> PhaseProfiler::getSummary() const
+{
+    std::vector<PhaseSummary> summary;
+
+    for (std::size_t phase = 0; phase < _phaseNames.size(); phase++)
+    {
+        const auto count = _counters[phase]->count.load(std::memory_order_relaxed);
+        const auto totalMs = _counters[phase]->totalNs.load(std::memory_order_relaxed) / 1e6;
+        const auto maxMs = _counters[phase]->maxNs.load(std::memory_order_relaxed) / 1e6;
+
+        summary.push_back({ _phaseNames[phase], count, totalMs, count > 0 ? totalMs / count : 0.0, maxMs });
+    }
+
+    return summary;
+}
+
+std::string PhaseProfiler::getSummaryTable() const
+{
+    std::size_t nameWidth = 5;
+    for (const auto& name : _phaseNames)
+        nameWidth = std::max(nameWidth, name.size());
+
+    std::ostringstream table;
+    char line[256];
+
+    std::snprintf(line, sizeof(line), "%-*s %10s %12s %10s %10s\n", static_cast<int>(nameWidth), "Phase", "Count", "Total [ms]", "Mean [ms]", "Max [ms]");
+    table << line;
+
+    for (const auto& phase : getSummary())
+    {
+        std::snprintf(line, sizeof(line), "%-*s %10llu %12.1f %10.3f %10.3f\n", static_cast<int>(nameWidth), phase.name.c_str(), static_cast<unsigned long long>(phase.count), phase.totalMs, phase.meanMs, phase.maxMs);
+        table << line;
+    }
+
+    return table.str();
+}
+
+std::string PhaseProfiler::toChromeTrace() const
+{
+    const auto numEvents = _numEvents.load(std::memory_order_acquire);
+    const auto numKept = std::min<std::uint64_t>(numEvents, _events.size());
+
+    std::ostringstream trace;
+    trace << std::fixed << std::setprecision(3);
+
+    trace << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    trace << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"" << escapeJson(_name) << "\"}}";
+
+    // Oldest first, timestamps and durations in microseconds
+    for (auto index = numEvents - numKept; index < numEvents; index++)
+    {
+        Event event;
+
+        if (!readEvent(index, event) || event.phase >= _phaseNames.size())
+            continue;
+
+        trace << ",{\"name\":\"" << escapeJson(_phaseNames[event.phase]) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+              << ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+    }
+
+    trace << "]}";
+
+    return trace.str();
+}
+
+bool PhaseProfiler::exportChromeTrace(const std::string& fileName) const
+{
+    std::ofstream file(fileName, std::ios::binary);
+
+    if (!file)
+        return false;
+
+    file << toChromeTrace();
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * PhaseProfiler
+ *
+ * Low-overhead timing of the phases of a computation, e.g. the steps of a gradient descent iteration.
+ * Every recorded phase updates lock-free per-phase counters and is written into a fixed-size ring buffer
+ * that keeps the most recent events. The events can be exported as Chrome trace / Perfetto JSON and the
+ * counters summarized as a table.
+ *
+ * Phases are added before recording starts; recording is thread-safe and never blocks. Every slot of the
+ * ring buffer carries a sequence number (seqlock), exporting while phases are recorded skips the events
+ * that are being overwritten.
+ */
+class PhaseProfiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using PhaseId = std::uint32_t;
+
+    /** Accumulated timings of a phase */
+    struct PhaseSummary
+    {
+        std::string     name;       /** Name of the phase */
+        std::uint64_t   count;      /** Number of recorded occurrences */
+        double          totalMs;    /** Summed duration in milliseconds */
+        double          meanMs;     /** Mean duration in milliseconds */
+        double          maxMs;      /** Longest duration in milliseconds */
+    };
+
+    /**
+     * Measures the lifetime of the scope as an occurrence of a phase, does nothing without a profiler
+     */
+    class ScopedPhase
+    {
+    public:
+        ScopedPhase(PhaseProfiler* profiler, PhaseId phase) :
+            _profiler(profiler),
+            _phase(phase),
+            _start(profiler ? Clock::now() : Clock::time_point())
+        {
+        }
+
+        ~ScopedPhase()
+        {
+            if (_profiler)
+                _profiler->record(_phase, _start, Clock::now());
+        }
+
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+    private:
+        PhaseProfiler*      _profiler;
+        PhaseId             _phase;
+        Clock::time_point   _start;
+    };
+
+public:
+    /**
+     * Constructor
+     * @param name Name of the profiled computation, the process name in the trace
+     * @param capacity Number of most recent events that are kept
+     */
+    PhaseProfiler(const std::string& name, std::size_t capacity = 1 << 16);
+
+    /**
+     * Constructor
+     * @param name Name of the profiled computation, the process name in the trace
+     * @param phases Names of the phases, their ids are their indices
+     * @param capacity Number of most recent events that are kept
+     */
+    PhaseProfiler(const std::string& name, const std::vector<std::string>& phases, std::size_t capacity = 1 << 16);
+
+    /** Add a phase, not thread-safe, add all phases before recording */
+    PhaseId addPhase(const std::string& name);
+
+    /** Record an occurrence of a phase */
+    void record(PhaseId phase, Clock::time_point start, Clock::time_point end);
+
+    /** Forget all recorded events and counters, not thread-safe */
+    void reset();
+
+    const std::string& getName() const { return _name; }
+
+    /** Counters of all phases in the order they were added */
+    std::vector<PhaseSummary> getSummary() const;
+
+    /** Counters as a fixed-width text table */
+    std::string getSummaryTable() const;
+
+    /** Events in the ring buffer as Chrome trace / Perfetto JSON */
+    std::string toChromeTrace() const;
+
+    /** Write toChromeTrace() to a file, returns false on failure */
+    bool exportChromeTrace(const std::string& fileName) const;
+
+private:
+    /** A single occurrence of a phase */
+    struct Event
+    {
+        PhaseId         phase;          /** Phase of the event */
+        std::uint32_t   thread;         /** Small id of the recording thread */
+        std::int64_t    startNs;        /** Start relative to the creation of the profiler */
+        std::int64_t    durationNs;     /** Duration */
+    };
+
+    /** Slot of the ring buffer, the fields are atomic such that reading a slot that is being written is not a data race */
+    struct EventSlot
+    {
+        std::atomic<std::uint64_t>  sequence{ 0 };      /** 2 * (event index + 1) once written, odd while being written */
+        std::atomic<PhaseId>        phase{ 0 };
+        std::atomic<std::uint32_t>  thread{ 0 };
+        std::atomic<std::int64_t>   startNs{ 0 };
+        std::atomic<std::int64_t>   durationNs{ 0 };
+    };
+
+    /** Copy of the event with the given index, false if its slot was not written yet, is being written or holds a newer event */
+    bool readEvent(std::uint64_t index, Event& event) const;
+
+    /** Lock-free counters of a phase */
+    struct Counters
+    {
+        std::atomic<std::uint64_t>  count{ 0 };
+        std::atomic<std::int64_t>   totalNs{ 0 };
+        std::atomic<std::int64_t>   maxNs{ 0 };
+    };
+
+private:
+    std::string                             _name;          /** Name of the profiled computation */
+    Clock::time_point                       _origin;        /** Time zero of the events */
+    std::vector<std::string>                _phaseNames;    /** Names of the phases */
+    std::vector<std::unique_ptr<Counters>>  _counters;      /** Counters per phase */
+    std::vector<EventSlot>                  _events;        /** Ring buffer of the most recent events */
+    std::atomic<std::uint64_t>              _numEvents;     /** Number of events recorded, the next slot is _numEvents % capacity */
+};
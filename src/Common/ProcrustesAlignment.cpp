@@ -0,0 +1,88 @@
+#include "ProcrustesAlignment.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+ProcrustesAlignment::ProcrustesAlignment() :
+    _reference(),
+    _lastRotation(0)
+{
+}
+
+void ProcrustesAlignment::reset()
+{
+    _reference.clear();
+    _lastRotation = 0;
+}
+
+const float* ProcrustesAlignment::align(const float* embedding, std::uint32_t numPoints)
+{
+    assert(embedding != nullptr || numPoints == 0);
+
+    const std::size_t numValues = 2ull * numPoints;
+
+    // The first embedding defines the frame
+    if (_reference.size() != numValues || numPoints == 0)
+    {
+        _reference.assign(embedding, embedding + numValues);
+        _lastRotation = 0;
+        return _reference.data();
+    }
+
+    // Sums of the coordinates and of the cross products between embedding (x) and reference (y)
+    double sumX0 = 0, sumX1 = 0, sumY0 = 0, sumY1 = 0;
+    double sumX0Y0 = 0, sumX0Y1 = 0, sumX1Y0 = 0, sumX1Y1 = 0;
+
+    const float* reference = _reference.data();
+
+#pragma omp parallel for schedule(static) reduction(+: sumX0, sumX1, sumY0, sumY1, sumX0Y0, sumX0Y1, sumX1Y0, sumX1Y1)
+    for (std::int64_t point = 0; point < static_cast<std::int64_t>(numPoints); point++)
+    {
+        const double x0 = embedding[2 * point], x1 = embedding[2 * point + 1];
+        const double y0 = reference[2 * point], y1 = reference[2 * point + 1];
+
+        sumX0 += x0;
+        sumX1 += x1;
+        sumY0 += y0;
+        sumY1 += y1;
+        sumX0Y0 += x0 * y0;
+        sumX0Y1 += x0 * y1;
+        sumX1Y0 += x1 * y0;
+        sumX1Y1 += x1 * y1;
+    }
+
+    const double n = numPoints;
+
+    const double meanX0 = sumX0 / n, meanX1 = sumX1 / n;
+    const double meanY0 = sumY0 / n, meanY1 = sumY1 / n;
+
+    // Centered cross-covariance
+    const double c00 = sumX0Y0 - n * meanX0 * meanY0;
+    const double c01 = sumX0Y1 - n * meanX0 * meanY1;
+    const double c10 = sumX1Y0 - n * meanX1 * meanY0;
+    const double c11 = sumX1Y1 - n * meanX1 * meanY1;
+
+    // The rotation maximizing the correlation with the reference, reflections are excluded
+    _lastRotation = std::atan2(c01 - c10, c00 + c11);
+
+    const float cosAngle = static_cast<float>(std::cos(_lastRotation));
+    const float sinAngle = static_cast<float>(std::sin(_lastRotation));
+
+    const float fMeanX0 = static_cast<float>(meanX0), fMeanX1 = static_cast<float>(meanX1);
+    const float fMeanY0 = static_cast<float>(meanY0), fMeanY1 = static_cast<float>(meanY1);
+
+    float* aligned = _reference.data();
+
+#pragma omp parallel for schedule(static)
+    for (std::int64_t point = 0; point < static_cast<std::int64_t>(numPoints); point++)
+    {
+        const float x0 = embedding[2 * point] - fMeanX0;
+        const float x1 = embedding[2 * point + 1] - fMeanX1;
+
+        aligned[2 * point] = cosAngle * x0 - sinAngle * x1 + fMeanY0;
+        aligned[2 * point + 1] = sinAngle * x0 + cosAngle * x1 + fMeanY1;
+    }
+
+    return _reference.data();
+}
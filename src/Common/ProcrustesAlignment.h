@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * ProcrustesAlignment
+ *
+ * Removes the global drift and rotation between consecutive 2D embeddings: every embedding is moved
+ * by the rotation and translation that best fit it (in the least squares sense) onto the previously
+ * aligned one. The transform is estimated in a single parallel reduction pass over the points.
+ */
+class ProcrustesAlignment
+{
+public:
+    ProcrustesAlignment();
+
+    /** Forget the reference, the next embedding is kept as is */
+    void reset();
+
+    /**
+     * Align an embedding to the previously aligned one
+     * @param embedding Point-major 2D embedding, 2 * numPoints values
+     * @param numPoints Number of points
+     * @return Aligned embedding, valid until the next call, which uses it as reference
+     */
+    const float* align(const float* embedding, std::uint32_t numPoints);
+
+    /** Rotation angle in radians of the last alignment */
+    double getLastRotation() const { return _lastRotation; }
+
+private:
+    std::vector<float>  _reference;     /** Last aligned embedding */
+    double              _lastRotation;  /** Rotation angle of the last alignment */
+};
@@ -0,0 +1,333 @@
+#include "RandomizedPca.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace
+{
+    // Number of rows of the data that are handed to a thread at once
+    constexpr std::int64_t _ROW_BLOCK_SIZE_ = 1024;
+
+    // Number of row blocks whose partial sums are held at once
+    constexpr std::int64_t _BLOCKS_PER_PASS_ = 64;
+
+    // Jacobi eigen solver of the small projected problem
+    constexpr int _JACOBI_MAX_SWEEPS_ = 100;
+    constexpr double _JACOBI_EPSILON_ = 1e-12;
+
+    /**
+     * Sum of width values over all rows, accumulate(rowBegin, rowEnd, partial) adds the values of a range of rows to partial.
+     * Every block of _ROW_BLOCK_SIZE_ rows gets its own partial sum and these are added in block order,
+     * such that the result does not depend on the number of threads or their scheduling.
+     */
+    template <typename Accumulate>
+    std::vector<double> sumRowBlocks(std::int64_t numRows, std::int64_t width, Accumulate accumulate)
+    {
+        std::vector<double> sum(width, 0.0);
+
+        const std::int64_t numBlocks = (numRows + _ROW_BLOCK_SIZE_ - 1) / _ROW_BLOCK_SIZE_;
+        std::vector<double> partials(std::min(numBlocks, _BLOCKS_PER_PASS_) * width);
+
+        for (std::int64_t passBegin = 0; passBegin < numBlocks; passBegin += _BLOCKS_PER_PASS_)
+        {
+            const std::int64_t numPassBlocks = std::min(_BLOCKS_PER_PASS_, numBlocks - passBegin);
+
+            std::fill(partials.begin(), partials.end(), 0.0);
+
+#pragma omp parallel for schedule(dynamic, 1)
+            for (std::int64_t block = 0; block < numPassBlocks; block++)
+            {
+                const std::int64_t rowBegin = (passBegin + block) * _ROW_BLOCK_SIZE_;
+                accumulate(rowBegin, std::min(numRows, rowBegin + _ROW_BLOCK_SIZE_), partials.data() + block * width);
+            }
+
+            for (std::int64_t block = 0; block < numPassBlocks; block++)
+                for (std::int64_t pos = 0; pos < width; pos++)
+                    sum[pos] += partials[block * width + pos];
+        }
+
+        return sum;
+    }
+
+    /** Column means of the point-major data */
+    std::vector<double> computeMean(const float* data, std::int64_t numRows, std::int64_t numCols)
+    {
+        std::vector<double> mean = sumRowBlocks(numRows, numCols, [data, numCols](std::int64_t rowBegin, std::int64_t rowEnd, double* partial) {
+            for (std::int64_t row = rowBegin; row < rowEnd; row++)
+            {
+                const float* x = data + row * numCols;
+                for (std::int64_t col = 0; col < numCols; col++)
+                    partial[col] += x[col];
+            }
+        });
+
+        for (auto& m : mean)
+            m /= std::max<std::int64_t>(1, numRows);
+
+        return mean;
+    }
+
+    /** result (numRows x k) = (data - mean) * right (numCols x k), all row-major */
+    void multiplyCentered(const float* data, const std::vector<double>& mean, std::int64_t numRows, std::int64_t numCols, const std::vector<float>& right, std::int64_t k, std::vector<float>& result)
+    {
+        result.assign(numRows * k, 0.f);
+
+        // Shift of the centering, mean * right, applied once per row instead of per element
+        std::vector<double> shift(k, 0.0);
+        for (std::int64_t col = 0; col < numCols; col++)
+            for (std::int64_t j = 0; j < k; j++)
+                shift[j] += mean[col] * right[col * k + j];
+
+#pragma omp parallel
+        {
+            std::vector<double> row(k);
+
+#pragma omp for schedule(dynamic, _ROW_BLOCK_SIZE_)
+            for (std::int64_t i = 0; i < numRows; i++)
+            {
+                const float* x = data + i * numCols;
+                std::fill(row.begin(), row.end(), 0.0);
+
+                for (std::int64_t col = 0; col < numCols; col++)
+                {
+                    const double value = x[col];
+                    const float* r = right.data() + col * k;
+                    for (std::int64_t j = 0; j < k; j++)
+                        row[j] += value * r[j];
+                }
+
+                for (std::int64_t j = 0; j < k; j++)
+                    result[i * k + j] = static_cast<float>(row[j] - shift[j]);
+            }
+        }
+    }
+
+    /** result (numCols x k) = (data - mean)^T * left (numRows x k), all row-major */
+    void multiplyCenteredTransposed(const float* data, const std::vector<double>& mean, std::int64_t numRows, std::int64_t numCols, const std::vector<float>& left, std::int64_t k, std::vector<float>& result)
+    {
+        // data^T * left followed by the column sums of left, for the centering
+        const std::vector<double> sum = sumRowBlocks(numRows, numCols * k + k, [data, &left, numCols, k](std::int64_t rowBegin, std::int64_t rowEnd, double* partial) {
+            double* columnSum = partial + numCols * k;
+
+            for (std::int64_t i = rowBegin; i < rowEnd; i++)
+            {
+                const float* x = data + i * numCols;
+                const float* l = left.data() + i * k;
+
+                for (std::int64_t col = 0; col < numCols; col++)
+                {
+                    const double value = x[col];
+                    double* s = partial + col * k;
+                    for (std::int64_t j = 0; j < k; j++)
+                        s[j] += value * l[j];
+                }
+
+                for (std::int64_t j = 0; j < k; j++)
+                    columnSum[j] += l[j];
+            }
+        });
+
+        const double* leftColumnSum = sum.data() + numCols * k;
+
+        result.resize(numCols * k);
+        for (std::int64_t col = 0; col < numCols; col++)
+            for (std::int64_t j = 0; j < k; j++)
+                result[col * k + j] = static_cast<float>(sum[col * k + j] - mean[col] * leftColumnSum[j]);
+    }
+
+    /** Orthonormalize the k columns of a row-major numRows x k matrix with modified Gram-Schmidt */
+    void orthonormalizeColumns(std::vector<float>& matrix, std::int64_t numRows, std::int64_t k)
+    {
+        for (std::int64_t j = 0; j < k; j++)
+        {
+            for (std::int64_t p = 0; p < j; p++)
+            {
+                const double dot = sumRowBlocks(numRows, 1, [&matrix, k, j, p](std::int64_t rowBegin, std::int64_t rowEnd, double* partial) {
+                    for (std::int64_t i = rowBegin; i < rowEnd; i++)
+                        *partial += static_cast<double>(matrix[i * k + j]) * matrix[i * k + p];
+                }).front();
+
+#pragma omp parallel for schedule(static)
+                for (std::int64_t i = 0; i < numRows; i++)
+                    matrix[i * k + j] -= static_cast<float>(dot * matrix[i * k + p]);
+            }
+
+            const double norm = std::sqrt(sumRowBlocks(numRows, 1, [&matrix, k, j](std::int64_t rowBegin, std::int64_t rowEnd, double* partial) {
+                for (std::int64_t i = rowBegin; i < rowEnd; i++)
+                    *partial += static_cast<double>(matrix[i * k + j]) * matrix[i * k + j];
+            }).front());
+
+            // Rank deficient directions are dropped
+            const double scale = norm > 0.0 ? 1.0 / norm : 0.0;
+
+#pragma omp parallel for schedule(static)
+            for (std::int64_t i = 0; i < numRows; i++)
+                matrix[i * k + j] = static_cast<float>(matrix[i * k + j] * scale);
+        }
+    }
+
+    /** Eigen decomposition of a symmetric k x k matrix with cyclic Jacobi rotations, eigenvectors are the columns of vectors */
+    void symmetricEigen(std::vector<double> matrix, std::int64_t k, std::vector<double>& values, std::vector<double>& vectors)
+    {
+        vectors.assign(k * k, 0.0);
+        for (std::int64_t i = 0; i < k; i++)
+            vectors[i * k + i] = 1.0;
+
+        for (int sweep = 0; sweep < _JACOBI_MAX_SWEEPS_; sweep++)
+        {
+            double offDiagonal = 0.0;
+            for (std::int64_t p = 0; p < k; p++)
+                for (std::int64_t q = p + 1; q < k; q++)
+                    offDiagonal += matrix[p * k + q] * matrix[p * k + q];
+
+            if (offDiagonal < _JACOBI_EPSILON_)
+                break;
+
+            for (std::int64_t p = 0; p < k; p++)
+            {
+                for (std::int64_t q = p + 1; q < k; q++)
+                {
+                    const double apq = matrix[p * k + q];
+                    if (std::abs(apq) < 1e-300)
+                        continue;
+
+                    const double theta = (matrix[q * k + q] - matrix[p * k + p]) / (2.0 * apq);
+                    const double t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                    const double c = 1.0 / std::sqrt(t * t + 1.0);
+                    const double s = t * c;
+
+                    for (std::int64_t r = 0; r < k; r++)
+                    {
+                        const double arp = matrix[r * k + p];
+                        const double arq = matrix[r * k + q];
+                        matrix[r * k + p] = c * arp - s * arq;
+                        matrix[r * k + q] = s * arp + c * arq;
+                    }
+
+                    for (std::int64_t r = 0; r < k; r++)
+                    {
+                        const double apr = matrix[p * k + r];
+                        const double aqr = matrix[q * k + r];
+                        matrix[p * k + r] = c * apr - s * aqr;
+                        matrix[q * k + r] = s * apr + c * aqr;
+                    }
+
+                    for (std::int64_t r = 0; r < k; r++)
+                    {
+                        const double vrp = vectors[r * k + p];
+                        const double vrq = vectors[r * k + q];
+                        vectors[r * k + p] = c * vrp - s * vrq;
+                        vectors[r * k + q] = s * vrp + c * vrq;
+                    }
+                }
+            }
+        }
+
+        values.resize(k);
+        for (std::int64_t i = 0; i < k; i++)
+            values[i] = matrix[i * k + i];
+    }
+}
+
+RandomizedPca::RandomizedPca(uint32_t numComponents, uint32_t numPowerIterations, uint32_t oversampling, uint64_t seed) :
+    _numComponents(numComponents),
+    _numPowerIterations(numPowerIterations),
+    _oversampling(oversampling),
+    _seed(seed)
+{
+}
+
+std::vector<float> RandomizedPca::computeProjection(const float* data, uint32_t numPoints, uint32_t numDimensions) const
+{
+    const std::int64_t n = numPoints;
+    const std::int64_t d = numDimensions;
+    const std::int64_t numComponents = _numComponents;
+
+    if (data == nullptr || n == 0 || numComponents == 0 || d < numComponents)
+        return {};
+
+    // Width of the sketch
+    const std::int64_t k = std::min<std::int64_t>(d, numComponents + _oversampling);
+
+    const std::vector<double> mean = computeMean(data, n, d);
+
+    // Gaussian test matrix, d x k
+    std::vector<float> omega(d * k);
+    {
+        std::mt19937_64 generator(_seed);
+        std::normal_distribution<float> normal(0.f, 1.f);
+        for (auto& value : omega)
+            value = normal(generator);
+    }
+
+    // Range finder with power iterations: Y = (X X^T)^q X Omega, re-orthonormalized in between for stability
+    std::vector<float> sketch;      // n x k
+    std::vector<float> coSketch;    // d x k
+
+    multiplyCentered(data, mean, n, d, omega, k, sketch);
+
+    for (uint32_t iteration = 0; iteration < _numPowerIterations; iteration++)
+    {
+        orthonormalizeColumns(sketch, n, k);
+        multiplyCenteredTransposed(data, mean, n, d, sketch, k, coSketch);
+        orthonormalizeColumns(coSketch, d, k);
+        multiplyCentered(data, mean, n, d, coSketch, k, sketch);
+    }
+
+    // Q, an orthonormal basis of the range
+    orthonormalizeColumns(sketch, n, k);
+
+    // B^T = X^T Q (d x k), the small problem B B^T = U S^2 U^T gives the scores X V = Q U S
+    multiplyCenteredTransposed(data, mean, n, d, sketch, k, coSketch);
+
+    std::vector<double> gram(k * k, 0.0);
+    for (std::int64_t row = 0; row < d; row++)
+        for (std::int64_t a = 0; a < k; a++)
+            for (std::int64_t b = 0; b < k; b++)
+                gram[a * k + b] += static_cast<double>(coSketch[row * k + a]) * coSketch[row * k + b];
+
+    std::vector<double> eigenValues, eigenVectors;
+    symmetricEigen(gram, k, eigenValues, eigenVectors);
+
+    // Largest eigenvalues first
+    std::vector<std::int64_t> order(k);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&eigenValues](std::int64_t a, std::int64_t b) { return eigenValues[a] > eigenValues[b]; });
+
+    // Coefficients of the components in the basis Q, scaled by the singular values, with deterministic signs
+    std::vector<double> coefficients(k * numComponents, 0.0);
+    for (std::int64_t c = 0; c < numComponents; c++)
+    {
+        const std::int64_t e = order[c];
+        const double singularValue = std::sqrt(std::max(0.0, eigenValues[e]));
+
+        std::int64_t largest = 0;
+        for (std::int64_t a = 1; a < k; a++)
+            if (std::abs(eigenVectors[a * k + e]) > std::abs(eigenVectors[largest * k + e]))
+                largest = a;
+
+        const double sign = eigenVectors[largest * k + e] < 0 ? -1.0 : 1.0;
+
+        for (std::int64_t a = 0; a < k; a++)
+            coefficients[a * numComponents + c] = sign * eigenVectors[a * k + e] * singularValue;
+    }
+
+    std::vector<float> projection(n * numComponents);
+
+#pragma omp parallel for schedule(static)
+    for (std::int64_t i = 0; i < n; i++)
+    {
+        for (std::int64_t c = 0; c < numComponents; c++)
+        {
+            double score = 0.0;
+            for (std::int64_t a = 0; a < k; a++)
+                score += sketch[i * k + a] * coefficients[a * numComponents + c];
+
+            projection[i * numComponents + c] = static_cast<float>(score);
+        }
+    }
+
+    return projection;
+}
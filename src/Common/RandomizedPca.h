@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * RandomizedPca
+ *
+ * Principal component projection via a randomized SVD (Halko, Martinsson & Tropp, 2011).
+ * The data is centered implicitly, i.e. never copied, and only accessed through blocked,
+ * multithreaded products with thin matrices of numComponents + oversampling columns.
+ * A few power iterations sharpen the subspace for slowly decaying spectra.
+ *
+ * The result only depends on the seed: sums over the points are added per fixed block of
+ * rows in block order, independent of the number of threads, and the signs of the components
+ * are fixed, such that repeated runs give the same projection.
+ */
+class RandomizedPca
+{
+public:
+    /**
+     * Constructor
+     * @param numComponents Number of principal components to project on
+     * @param numPowerIterations Number of power (subspace) iterations
+     * @param oversampling Number of additional random directions
+     * @param seed Seed of the random test matrix
+     */
+    RandomizedPca(uint32_t numComponents, uint32_t numPowerIterations = 2, uint32_t oversampling = 10, uint64_t seed = 0x5eed);
+
+    /**
+     * Project the data onto its first principal components
+     * @param data Point-major data, numPoints * numDimensions values
+     * @return Point-major projection, numPoints * numComponents values, empty if the data has fewer dimensions than components
+     */
+    std::vector<float> computeProjection(const float* data, uint32_t numPoints, uint32_t numDimensions) const;
+
+private:
+    uint32_t    _numComponents;         /** Number of principal components */
+    uint32_t    _numPowerIterations;    /** Number of power iterations */
+    uint32_t    _oversampling;          /** Additional random directions */
+    uint64_t    _seed;                  /** Seed of the random test matrix */
+};
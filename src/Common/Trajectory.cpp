@@ -0,0 +1,384 @@
+#include "Trajectory.h"
+
+#include "CancellationToken.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+    /** Round a float to the nearest IEEE 754 binary16 value, ties to even */
+    std::uint16_t floatToHalf(float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        const std::uint32_t sign = (bits >> 16) & 0x8000u;
+        const std::uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+        // Infinity and NaN
+        if (magnitude >= 0x7F800000u)
+            return static_cast<std::uint16_t>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u));
+
+        // Rounds to 65520 or more
+        if (magnitude >= 0x477FF000u)
+            return static_cast<std::uint16_t>(sign | 0x7C00u);
+
+        // Below half of the smallest subnormal
+        if (magnitude < 0x33000000u)
+            return static_cast<std::uint16_t>(sign);
+
+        // Subnormal, in units of 2^-24
+        if (magnitude < 0x38800000u)
+        {
+            const std::uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+            const std::uint32_t shift = 126u - (magnitude >> 23);
+            const std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const std::uint32_t halfway = 1u << (shift - 1);
+
+            std::uint32_t half = mantissa >> shift;
+            if (remainder > halfway || (remainder == halfway && (half & 1u)))
+                half++;
+
+            return static_cast<std::uint16_t>(sign | half);
+        }
+
+        // Normal, rebias the exponent from 127 to 15, a carry of the rounding moves into the exponent
+        std::uint32_t half = (magnitude - 0x38000000u) >> 13;
+        const std::uint32_t remainder = magnitude & 0x1FFFu;
+
+        if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)))
+            half++;
+
+        return static_cast<std::uint16_t>(sign | half);
+    }
+
+    /** Exact float value of an IEEE 754 binary16 value */
+    float halfToFloat(std::uint16_t half)
+    {
+        const std::uint32_t sign = static_cast<std::uint32_t>(half & 0x8000u) << 16;
+        const std::uint32_t exponent = (half >> 10) & 0x1Fu;
+        std::uint32_t mantissa = half & 0x3FFu;
+        std::uint32_t bits;
+
+        if (exponent == 0x1Fu)
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        else if (exponent != 0)
+            bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+        else if (mantissa == 0)
+            bits = sign;
+        else
+        {
+            // Subnormal, normalize the mantissa
+            std::uint32_t floatExponent = 113;
+            while (!(mantissa & 0x400u))
+            {
+                mantissa <<= 1;
+                floatExponent--;
+            }
+
+            bits = sign | (floatExponent << 23) | ((mantissa & 0x3FFu) << 13);
+        }
+
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+Trajectory::Trajectory(std::uint32_t numPoints, std::uint32_t numDimensions, std::uint32_t pointBlockSize, std::uint32_t timeBlockSize) :
+    _numPoints(0),
+    _numDimensions(0),
+    _pointBlockSize(std::max<std::uint32_t>(1, pointBlockSize)),
+    _timeBlockSize(std::max<std::uint32_t>(1, timeBlockSize)),
+    _numPointBlocks(0),
+    _precision(Precision::Float32),
+    _timeBlocks(),
+    _halfTimeBlocks(),
+    _iterations(),
+    _offset(),
+    _scale()
+{
+    reset(numPoints, numDimensions);
+}
+
+void Trajectory::reset(std::uint32_t numPoints, std::uint32_t numDimensions)
+{
+    _numPoints = numPoints;
+    _numDimensions = numDimensions;
+    _numPointBlocks = (numPoints + _pointBlockSize - 1) / _pointBlockSize;
+
+    clear();
+}
+
+void Trajectory::clear()
+{
+    _timeBlocks.clear();
+    _halfTimeBlocks.clear();
+    _iterations.clear();
+
+    clearNormalization();
+}
+
+void Trajectory::setPrecision(Precision precision)
+{
+    if (precision == _precision)
+        return;
+
+    if (precision == Precision::Float16)
+    {
+        for (const auto& timeBlock : _timeBlocks)
+        {
+            _halfTimeBlocks.emplace_back(timeBlock.size());
+            std::transform(timeBlock.begin(), timeBlock.end(), _halfTimeBlocks.back().begin(), floatToHalf);
+        }
+
+        _timeBlocks.clear();
+    }
+    else
+    {
+        for (const auto& timeBlock : _halfTimeBlocks)
+        {
+            _timeBlocks.emplace_back(timeBlock.size());
+            std::transform(timeBlock.begin(), timeBlock.end(), _timeBlocks.back().begin(), halfToFloat);
+        }
+
+        _halfTimeBlocks.clear();
+    }
+
+    _precision = precision;
+}
+
+std::size_t Trajectory::getMemoryUsage() const
+{
+    return estimateMemoryUsage(getNumTimesteps(), _precision);
+}
+
+std::size_t Trajectory::estimateMemoryUsage(std::uint32_t numTimesteps, Precision precision) const
+{
+    const std::size_t numTimeBlocks = (static_cast<std::size_t>(numTimesteps) + _timeBlockSize - 1) / _timeBlockSize;
+    const std::size_t bytesPerValue = precision == Precision::Float16 ? sizeof(std::uint16_t) : sizeof(float);
+
+    return numTimeBlocks * _numPointBlocks * tileSize() * bytesPerValue;
+}
+
+void Trajectory::normalize(bool keepAspectRatio)
+{
+    clearNormalization();
+
+    if (empty() || _numPoints == 0)
+        return;
+
+    std::vector<float> minimum(_numDimensions), maximum(_numDimensions);
+    std::vector<float> values(static_cast<std::size_t>(_pointBlockSize) * _numDimensions);
+
+    // Bounds over all recorded values, skipping the padding of the last point block
+    for (std::uint32_t timestep = 0; timestep < getNumTimesteps(); timestep++)
+    {
+        for (std::uint32_t pointBlock = 0; pointBlock < _numPointBlocks; pointBlock++)
+        {
+            const auto firstPoint = pointBlock * _pointBlockSize;
+            const auto numPointsInBlock = std::min(_pointBlockSize, _numPoints - firstPoint);
+
+            // Without normalization the values are read as stored
+            read(firstPoint, timestep, static_cast<std::size_t>(numPointsInBlock) * _numDimensions, values.data());
+
+            if (timestep == 0 && pointBlock == 0)
+            {
+                std::copy_n(values.begin(), _numDimensions, minimum.begin());
+                std::copy_n(values.begin(), _numDimensions, maximum.begin());
+            }
+
+            for (std::size_t i = 0; i < static_cast<std::size_t>(numPointsInBlock) * _numDimensions; i++)
+            {
+                const auto d = i % _numDimensions;
+
+                minimum[d] = std::min(minimum[d], values[i]);
+                maximum[d] = std::max(maximum[d], values[i]);
+            }
+        }
+    }
+
+    std::vector<float> halfRange(_numDimensions);
+
+    _offset.resize(_numDimensions);
+    _scale.resize(_numDimensions);
+
+    for (std::uint32_t d = 0; d < _numDimensions; d++)
+    {
+        _offset[d] = (minimum[d] + maximum[d]) / 2;
+        halfRange[d] = (maximum[d] - minimum[d]) / 2;
+    }
+
+    if (keepAspectRatio)
+        std::fill(halfRange.begin(), halfRange.end(), *std::max_element(halfRange.begin(), halfRange.end()));
+
+    for (std::uint32_t d = 0; d < _numDimensions; d++)
+        _scale[d] = halfRange[d] > 0 ? 1 / halfRange[d] : 0;
+}
+
+void Trajectory::clearNormalization()
+{
+    _offset.clear();
+    _scale.clear();
+}
+
+void Trajectory::read(std::uint32_t point, std::uint32_t timestep, std::size_t numValues, float* out) const
+{
+    const auto timeBlock = timestep / _timeBlockSize;
+    const auto first = offset(point, timestep);
+
+    if (_precision == Precision::Float16)
+        std::transform(_halfTimeBlocks[timeBlock].begin() + first, _halfTimeBlocks[timeBlock].begin() + first + numValues, out, halfToFloat);
+    else
+        std::copy_n(_timeBlocks[timeBlock].begin() + first, numValues, out);
+
+    if (_offset.empty())
+        return;
+
+    for (std::size_t i = 0; i < numValues; i++)
+    {
+        const auto d = i % _numDimensions;
+        out[i] = (out[i] - _offset[d]) * _scale[d];
+    }
+}
+
+void Trajectory::write(std::uint32_t point, std::uint32_t timestep, std::size_t numValues, const float* values)
+{
+    const auto timeBlock = timestep / _timeBlockSize;
+    const auto first = offset(point, timestep);
+
+    if (_precision == Precision::Float16)
+        std::transform(values, values + numValues, _halfTimeBlocks[timeBlock].begin() + first, floatToHalf);
+    else
+        std::copy_n(values, numValues, _timeBlocks[timeBlock].begin() + first);
+}
+
+std::size_t Trajectory::offset(std::uint32_t point, std::uint32_t timestep) const
+{
+    const std::size_t pointBlock = point / _pointBlockSize;
+    const std::size_t pointInBlock = point % _pointBlockSize;
+    const std::size_t timeInBlock = timestep % _timeBlockSize;
+
+    return pointBlock * tileSize() + (timeInBlock * _pointBlockSize + pointInBlock) * _numDimensions;
+}
+
+void Trajectory::append(const float* embedding, int iteration)
+{
+    assert(embedding != nullptr || _numPoints == 0);
+
+    const auto timestep = getNumTimesteps();
+
+    if (timestep % _timeBlockSize == 0)
+    {
+        if (_precision == Precision::Float16)
+            _halfTimeBlocks.emplace_back(static_cast<std::size_t>(_numPointBlocks) * tileSize());
+        else
+            _timeBlocks.emplace_back(static_cast<std::size_t>(_numPointBlocks) * tileSize());
+    }
+
+    // One contiguous run per point block
+    for (std::uint32_t pointBlock = 0; pointBlock < _numPointBlocks; pointBlock++)
+    {
+        const auto firstPoint = pointBlock * _pointBlockSize;
+        const auto numPointsInBlock = std::min(_pointBlockSize, _numPoints - firstPoint);
+
+        write(firstPoint, timestep, static_cast<std::size_t>(numPointsInBlock) * _numDimensions, embedding + static_cast<std::size_t>(firstPoint) * _numDimensions);
+    }
+
+    _iterations.push_back(iteration);
+}
+
+std::uint32_t Trajectory::findTimestep(int iteration) const
+{
+    const auto it = std::upper_bound(_iterations.begin(), _iterations.end(), iteration);
+
+    if (it == _iterations.begin())
+        return 0;
+
+    return static_cast<std::uint32_t>(std::distance(_iterations.begin(), it) - 1);
+}
+
+std::pair<std::uint32_t, std::uint32_t> Trajectory::findTimesteps(int beginIteration, int endIteration) const
+{
+    const auto first = std::lower_bound(_iterations.begin(), _iterations.end(), beginIteration);
+    const auto last = std::lower_bound(first, _iterations.end(), endIteration);
+
+    return { static_cast<std::uint32_t>(std::distance(_iterations.begin(), first)), static_cast<std::uint32_t>(std::distance(_iterations.begin(), last)) };
+}
+
+void Trajectory::copySlice(std::uint32_t timestep, float* out) const
+{
+    assert(timestep < getNumTimesteps());
+
+    for (std::uint32_t pointBlock = 0; pointBlock < _numPointBlocks; pointBlock++)
+    {
+        const auto firstPoint = pointBlock * _pointBlockSize;
+        const auto numPointsInBlock = std::min(_pointBlockSize, _numPoints - firstPoint);
+
+        read(firstPoint, timestep, static_cast<std::size_t>(numPointsInBlock) * _numDimensions, out + static_cast<std::size_t>(firstPoint) * _numDimensions);
+    }
+}
+
+std::vector<float> Trajectory::getSlice(std::uint32_t timestep) const
+{
+    std::vector<float> slice(static_cast<std::size_t>(_numPoints) * _numDimensions);
+    copySlice(timestep, slice.data());
+    return slice;
+}
+
+void Trajectory::copyPointTrajectory(std::uint32_t point, float* out) const
+{
+    assert(point < _numPoints);
+
+    for (std::uint32_t timestep = 0; timestep < getNumTimesteps(); timestep++)
+        read(point, timestep, _numDimensions, out + static_cast<std::size_t>(timestep) * _numDimensions);
+}
+
+void Trajectory::copyPointTrajectory(std::uint32_t point, const std::vector<std::uint32_t>& timesteps, float* out) const
+{
+    assert(point < _numPoints);
+
+    for (std::size_t i = 0; i < timesteps.size(); i++)
+    {
+        assert(timesteps[i] < getNumTimesteps());
+        read(point, timesteps[i], _numDimensions, out + i * _numDimensions);
+    }
+}
+
+std::vector<float> Trajectory::getPointTrajectory(std::uint32_t point) const
+{
+    std::vector<float> trajectory(static_cast<std::size_t>(getNumTimesteps()) * _numDimensions);
+    copyPointTrajectory(point, trajectory.data());
+    return trajectory;
+}
+
+std::vector<float> Trajectory::toPointMajor() const
+{
+    return toPointMajor(0, getNumTimesteps());
+}
+
+std::vector<float> Trajectory::toPointMajor(std::uint32_t firstTimestep, std::uint32_t lastTimestep, const CancellationToken* cancellation) const
+{
+    assert(firstTimestep <= lastTimestep && lastTimestep <= getNumTimesteps());
+
+    const std::size_t pointStride = static_cast<std::size_t>(lastTimestep - firstTimestep) * _numDimensions;
+
+    std::vector<float> pointMajor(pointStride * _numPoints);
+
+#pragma omp parallel for schedule(static)
+    for (std::int64_t point = 0; point < static_cast<std::int64_t>(_numPoints); point++)
+    {
+        if (cancellation && cancellation->isCancelled())
+            continue;
+
+        float* out = pointMajor.data() + point * pointStride;
+
+        for (std::uint32_t timestep = firstTimestep; timestep < lastTimestep; timestep++)
+            read(static_cast<std::uint32_t>(point), timestep, _numDimensions, out + static_cast<std::size_t>(timestep - firstTimestep) * _numDimensions);
+    }
+
+    return pointMajor;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class CancellationToken;
+
+/**
+ * Trajectory
+ *
+ * Embeddings recorded over the iterations of a gradient descent. The snapshots are stored in tiles of
+ * a block of points times a block of timesteps, inside a tile timestep by timestep. A time slice, i.e.
+ * the embedding at one recorded iteration, is thereby a sequence of contiguous runs of a point block,
+ * and the trajectory of a single point stays within one tile per block of timesteps.
+ *
+ * Snapshots are stored as recorded, a normalization set with normalize() is applied when reading them.
+ * With half precision the values are stored as IEEE 754 binary16 (about three significant digits),
+ * which halves the memory of the tiles.
+ */
+class Trajectory
+{
+public:
+    /** Storage type of the recorded values */
+    enum class Precision
+    {
+        Float32,    /** Single precision, values are stored exactly */
+        Float16     /** Half precision */
+    };
+
+    /**
+     * Constructor
+     * @param numPoints Number of points of every snapshot
+     * @param numDimensions Number of values per point of every snapshot
+     * @param pointBlockSize Number of points per tile
+     * @param timeBlockSize Number of timesteps per tile
+     */
+    Trajectory(std::uint32_t numPoints = 0, std::uint32_t numDimensions = 2, std::uint32_t pointBlockSize = 256, std::uint32_t timeBlockSize = 16);
+
+    /** Remove all snapshots and change the snapshot size */
+    void reset(std::uint32_t numPoints, std::uint32_t numDimensions);
+
+    /** Remove all snapshots */
+    void clear();
+
+    /** Change the storage type, converts the snapshots recorded so far */
+    void setPrecision(Precision precision);
+    Precision getPrecision() const { return _precision; }
+
+    /** Bytes of the tiles of the recorded snapshots */
+    std::size_t getMemoryUsage() const;
+
+    /** Bytes of the tiles of numTimesteps snapshots of the current size */
+    std::size_t estimateMemoryUsage(std::uint32_t numTimesteps, Precision precision) const;
+
+    /**
+     * Map the recorded values to [-1, 1] when reading them, snapshots appended later are included after calling it again
+     * @param keepAspectRatio Scale all dimensions by the same factor around the center of the values, otherwise each dimension is stretched to [-1, 1] separately
+     */
+    void normalize(bool keepAspectRatio);
+
+    /** Read the values as recorded */
+    void clearNormalization();
+
+    /**
+     * Record a snapshot
+     * @param embedding Point-major embedding, numPoints * numDimensions values
+     * @param iteration Gradient descent iteration of the snapshot
+     */
+    void append(const float* embedding, int iteration);
+
+    std::uint32_t getNumPoints() const { return _numPoints; }
+    std::uint32_t getNumDimensions() const { return _numDimensions; }
+    std::uint32_t getNumTimesteps() const { return static_cast<std::uint32_t>(_iterations.size()); }
+    bool empty() const { return _iterations.empty(); }
+
+    /** Iteration of every recorded timestep */
+    const std::vector<int>& getIterations() const { return _iterations; }
+
+    /** Timestep recorded last at or before the iteration, 0 if the iteration precedes all timesteps */
+    std::uint32_t findTimestep(int iteration) const;
+
+    /** Range [first, last) of the timesteps recorded in the iterations [beginIteration, endIteration) */
+    std::pair<std::uint32_t, std::uint32_t> findTimesteps(int beginIteration, int endIteration) const;
+
+    /**
+     * Embedding at a recorded timestep
+     * @param timestep Index of the timestep
+     * @param out Point-major destination of numPoints * numDimensions values
+     */
+    void copySlice(std::uint32_t timestep, float* out) const;
+    std::vector<float> getSlice(std::uint32_t timestep) const;
+
+    /**
+     * Positions of a single point over all recorded timesteps
+     * @param point Index of the point
+     * @param out Destination of numTimesteps * numDimensions values
+     */
+    void copyPointTrajectory(std::uint32_t point, float* out) const;
+    std::vector<float> getPointTrajectory(std::uint32_t point) const;
+
+    /**
+     * Positions of a single point at selected timesteps
+     * @param point Index of the point
+     * @param timesteps Indices of the timesteps
+     * @param out Destination of timesteps.size() * numDimensions values
+     */
+    void copyPointTrajectory(std::uint32_t point, const std::vector<std::uint32_t>& timesteps, float* out) const;
+
+    /** All trajectories point-major, for every point its positions over time: [x(i,t0), y(i,t0), x(i,t1), y(i,t1), ...] */
+    std::vector<float> toPointMajor() const;
+
+    /**
+     * Trajectories of the timesteps [firstTimestep, lastTimestep) point-major
+     * @param cancellation Optional, once cancelled the remaining points are skipped and the records are incomplete
+     */
+    std::vector<float> toPointMajor(std::uint32_t firstTimestep, std::uint32_t lastTimestep, const CancellationToken* cancellation = nullptr) const;
+
+private:
+    /** Values of a tile */
+    std::size_t tileSize() const { return static_cast<std::size_t>(_pointBlockSize) * _timeBlockSize * _numDimensions; }
+
+    /** Offset of (point, timestep) within the block of its timestep */
+    std::size_t offset(std::uint32_t point, std::uint32_t timestep) const;
+
+    /** Copy the values of consecutive points of a tile starting at the first dimension, applying the normalization */
+    void read(std::uint32_t point, std::uint32_t timestep, std::size_t numValues, float* out) const;
+
+    /** Store the values of consecutive points of a tile starting at the first dimension */
+    void write(std::uint32_t point, std::uint32_t timestep, std::size_t numValues, const float* values);
+
+private:
+    std::uint32_t                              _numPoints;         /** Number of points of every snapshot */
+    std::uint32_t                              _numDimensions;     /** Number of values per point */
+    std::uint32_t                              _pointBlockSize;    /** Number of points per tile */
+    std::uint32_t                              _timeBlockSize;     /** Number of timesteps per tile */
+    std::uint32_t                              _numPointBlocks;    /** Number of tiles per block of timesteps */
+    Precision                                  _precision;         /** Storage type of the values */
+    std::vector<std::vector<float>>            _timeBlocks;        /** Per block of timesteps all its tiles, the last point block is padded */
+    std::vector<std::vector<std::uint16_t>>    _halfTimeBlocks;    /** Same as _timeBlocks for half precision storage */
+    std::vector<int>                           _iterations;        /** Iteration of every recorded timestep */
+    std::vector<float>                         _offset;            /** Per dimension value that is mapped to 0, empty without normalization */
+    std::vector<float>                         _scale;             /** Per dimension factor of the normalization */
+};
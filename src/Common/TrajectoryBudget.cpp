@@ -0,0 +1,118 @@
+#include "TrajectoryBudget.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    // Point-major records of the published trajectory and their copy in the output data set
+    constexpr std::size_t _PUBLISHED_COPIES_ = 2;
+
+    std::string formatBytes(std::size_t bytes)
+    {
+        char text[32];
+
+        if (bytes >= (std::size_t(1) << 30))
+            std::snprintf(text, sizeof(text), "%.1f GB", bytes / static_cast<double>(std::size_t(1) << 30));
+        else
+            std::snprintf(text, sizeof(text), "%.0f MB", bytes / static_cast<double>(std::size_t(1) << 20));
+
+        return text;
+    }
+}
+
+TrajectoryBudget::TrajectoryBudget(std::size_t ceilingBytes) :
+    _ceilingBytes(ceilingBytes)
+{
+}
+
+std::uint32_t TrajectoryBudget::countRecorded(int beginIteration, int endIteration, int subsampleFactor)
+{
+    if (endIteration <= beginIteration || subsampleFactor < 1)
+        return 0;
+
+    // Multiples of the factor below endIteration minus those below beginIteration, iterations are non-negative
+    const auto multiplesBelow = [subsampleFactor](int iteration) -> int {
+        return (std::max(iteration, 0) + subsampleFactor - 1) / subsampleFactor;
+    };
+
+    return static_cast<std::uint32_t>(multiplesBelow(endIteration) - multiplesBelow(beginIteration));
+}
+
+std::size_t TrajectoryBudget::estimate(const Trajectory& trajectory, int beginIteration, int endIteration, int subsampleFactor, Trajectory::Precision precision, bool publishTrajectory)
+{
+    const auto numTimesteps = trajectory.getNumTimesteps() + countRecorded(beginIteration, endIteration, subsampleFactor);
+
+    std::size_t bytes = trajectory.estimateMemoryUsage(numTimesteps, precision);
+
+    if (publishTrajectory)
+        bytes += _PUBLISHED_COPIES_ * static_cast<std::size_t>(numTimesteps) * trajectory.getNumPoints() * trajectory.getNumDimensions() * sizeof(float);
+
+    return bytes;
+}
+
+TrajectoryBudget::Plan TrajectoryBudget::plan(const Trajectory& trajectory, int beginIteration, int endIteration, int subsampleFactor, bool publishTrajectory) const
+{
+    subsampleFactor = std::max(subsampleFactor, 1);
+
+    // Values that are already rounded to half precision are not stored in single precision again
+    Plan plan = { Policy::None, subsampleFactor, trajectory.getPrecision(), 0, _ceilingBytes };
+
+    if (trajectory.empty())
+        plan.precision = Trajectory::Precision::Float32;
+
+    const auto fits = [this, &plan, &trajectory, beginIteration, endIteration, publishTrajectory]() -> bool {
+        plan.estimatedBytes = estimate(trajectory, beginIteration, endIteration, plan.subsampleFactor, plan.precision, publishTrajectory);
+        return _ceilingBytes == 0 || plan.estimatedBytes <= _ceilingBytes;
+    };
+
+    if (fits())
+        return plan;
+
+    if (plan.precision != Trajectory::Precision::Float16)
+    {
+        plan.policy = Policy::Quantize;
+        plan.precision = Trajectory::Precision::Float16;
+
+        if (fits())
+            return plan;
+    }
+
+    // Smallest factor that fits, beyond the number of iterations at most one iteration is recorded
+    plan.policy = Policy::RaiseSubsampleFactor;
+
+    const int numIterations = std::max(endIteration - beginIteration, 1);
+
+    for (plan.subsampleFactor = subsampleFactor + 1; plan.subsampleFactor <= numIterations; plan.subsampleFactor++)
+        if (fits())
+            return plan;
+
+    plan.policy = Policy::StatisticsOnly;
+    plan.subsampleFactor = subsampleFactor;
+    plan.estimatedBytes = 0;
+
+    return plan;
+}
+
+std::string TrajectoryBudget::describe(const Plan& plan)
+{
+    const auto ceiling = plan.ceilingBytes > 0 ? " of " + formatBytes(plan.ceilingBytes) : std::string();
+    const auto recording = formatBytes(plan.estimatedBytes) + ceiling + ", every " + std::to_string(plan.subsampleFactor) + " iters";
+
+    switch (plan.policy)
+    {
+    case Policy::None:
+        return recording;
+
+    case Policy::Quantize:
+        return recording + ", half precision";
+
+    case Policy::RaiseSubsampleFactor:
+        return recording + ", half precision (subsample factor raised)";
+
+    case Policy::StatisticsOnly:
+        return "Trajectory exceeds" + ceiling.substr(3) + ", statistics only";
+    }
+
+    return recording;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Trajectory.h"
+
+#include <cstddef>
+#include <string>
+
+/**
+ * TrajectoryBudget
+ *
+ * Estimates the memory of recording the embeddings of a gradient descent before it starts and adapts the
+ * recording to a memory ceiling. The estimate covers the tiles of the trajectory and, if the whole trajectory
+ * is published at the end, its point-major records and their copy in the output data set.
+ *
+ * When the recording does not fit, the policies are tried in order: store the values in half precision,
+ * additionally record fewer iterations, and finally keep no embeddings but only the trajectory statistics.
+ */
+class TrajectoryBudget
+{
+public:
+    /** Adaptation applied to fit the ceiling, every policy includes the previous ones */
+    enum class Policy
+    {
+        None,                   /** Recording fits as configured */
+        Quantize,               /** Values are stored in half precision */
+        RaiseSubsampleFactor,   /** Fewer iterations are recorded */
+        StatisticsOnly          /** No embeddings are recorded */
+    };
+
+    /** Recording settings that fit the ceiling */
+    struct Plan
+    {
+        Policy                  policy;             /** Applied adaptation */
+        int                     subsampleFactor;    /** Every subsampleFactor-th iteration is recorded */
+        Trajectory::Precision   precision;          /** Storage type of the recorded values */
+        std::size_t             estimatedBytes;     /** Peak memory of the recording */
+        std::size_t             ceilingBytes;       /** Memory ceiling, 0 without a ceiling */
+    };
+
+public:
+    /**
+     * Constructor
+     * @param ceilingBytes Memory ceiling of the recording, 0 for no ceiling
+     */
+    TrajectoryBudget(std::size_t ceilingBytes);
+
+    /**
+     * Recording settings for the iterations [beginIteration, endIteration), appended to the trajectory
+     * @param trajectory Trajectory that is recorded into, reset to the size of the snapshots
+     * @param subsampleFactor Configured subsample factor
+     * @param publishTrajectory Whether the whole trajectory is published as point-major records at the end
+     */
+    Plan plan(const Trajectory& trajectory, int beginIteration, int endIteration, int subsampleFactor, bool publishTrajectory) const;
+
+    /** Peak memory of recording the iterations [beginIteration, endIteration) with the given settings */
+    static std::size_t estimate(const Trajectory& trajectory, int beginIteration, int endIteration, int subsampleFactor, Trajectory::Precision precision, bool publishTrajectory);
+
+    /** Number of iterations in [beginIteration, endIteration) that are a multiple of the subsample factor */
+    static std::uint32_t countRecorded(int beginIteration, int endIteration, int subsampleFactor);
+
+    /** Short description of a plan, e.g. for the user interface */
+    static std::string describe(const Plan& plan);
+
+private:
+    std::size_t     _ceilingBytes;      /** Memory ceiling, 0 without a ceiling */
+};
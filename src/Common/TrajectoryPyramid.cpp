@@ -0,0 +1,186 @@
+#include "TrajectoryPyramid.h"
+
+#include "Trajectory.h"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace
+{
+    // Cells per axis of the grid over the last embedding that stratifies the point levels
+    constexpr std::uint32_t _STRATIFICATION_GRID_SIZE_ = 64;
+
+    // No point level with fewer points is built
+    constexpr std::size_t _MIN_LEVEL_POINTS_ = 1000;
+
+    /** Deterministic pseudo-random order of the points within a cell */
+    std::uint64_t hashPoint(std::uint64_t point)
+    {
+        // splitmix64 finalizer
+        point += 0x9E3779B97F4A7C15ull;
+        point = (point ^ (point >> 30)) * 0xBF58476D1CE4E5B9ull;
+        point = (point ^ (point >> 27)) * 0x94D049BB133111EBull;
+        return point ^ (point >> 31);
+    }
+}
+
+TrajectoryPyramid::TrajectoryPyramid() :
+    _numDimensions(0),
+    _pointLevels(),
+    _timeLevels()
+{
+}
+
+void TrajectoryPyramid::clear()
+{
+    _numDimensions = 0;
+    _pointLevels.clear();
+    _timeLevels.clear();
+}
+
+void TrajectoryPyramid::build(const Trajectory& trajectory)
+{
+    clear();
+
+    if (trajectory.empty() || trajectory.getNumPoints() == 0)
+        return;
+
+    _numDimensions = trajectory.getNumDimensions();
+
+    buildTimeLevels(trajectory);
+    buildPointLevels(trajectory);
+}
+
+void TrajectoryPyramid::buildTimeLevels(const Trajectory& trajectory)
+{
+    const auto numTimesteps = trajectory.getNumTimesteps();
+
+    std::vector<std::uint32_t> timesteps(numTimesteps);
+    std::iota(timesteps.begin(), timesteps.end(), 0u);
+
+    _timeLevels.push_back(std::move(timesteps));
+
+    for (std::uint32_t stride = 2; stride / 2 < numTimesteps && _timeLevels.back().size() > 2; stride *= 2)
+    {
+        std::vector<std::uint32_t> level;
+
+        for (std::uint32_t timestep = 0; timestep < numTimesteps; timestep += stride)
+            level.push_back(timestep);
+
+        // The final embedding is part of every level
+        if (level.back() != numTimesteps - 1)
+            level.push_back(numTimesteps - 1);
+
+        if (level.size() >= _timeLevels.back().size())
+            break;
+
+        _timeLevels.push_back(std::move(level));
+    }
+}
+
+void TrajectoryPyramid::buildPointLevels(const Trajectory& trajectory)
+{
+    const auto numPoints = trajectory.getNumPoints();
+    const auto numDimensions = trajectory.getNumDimensions();
+
+    std::vector<std::uint32_t> allPoints(numPoints);
+    std::iota(allPoints.begin(), allPoints.end(), 0u);
+
+    _pointLevels.push_back(std::move(allPoints));
+
+    if (numPoints / 2 < _MIN_LEVEL_POINTS_)
+        return;
+
+    // Grid cell of every point in the last embedding, over the first two dimensions
+    const auto lastSlice = trajectory.getSlice(trajectory.getNumTimesteps() - 1);
+
+    float minimum[2] = { lastSlice[0], numDimensions > 1 ? lastSlice[1] : 0.f };
+    float maximum[2] = { minimum[0], minimum[1] };
+
+    for (std::uint32_t point = 0; point < numPoints; point++)
+        for (std::uint32_t d = 0; d < std::min(numDimensions, 2u); d++)
+        {
+            minimum[d] = std::min(minimum[d], lastSlice[static_cast<std::size_t>(point) * numDimensions + d]);
+            maximum[d] = std::max(maximum[d], lastSlice[static_cast<std::size_t>(point) * numDimensions + d]);
+        }
+
+    const auto cellOf = [&](std::uint32_t point) -> std::uint32_t {
+        std::uint32_t cell = 0;
+
+        for (std::uint32_t d = 0; d < std::min(numDimensions, 2u); d++)
+        {
+            const float range = maximum[d] - minimum[d];
+            const float relative = range > 0 ? (lastSlice[static_cast<std::size_t>(point) * numDimensions + d] - minimum[d]) / range : 0.f;
+            const auto index = std::min(_STRATIFICATION_GRID_SIZE_ - 1, static_cast<std::uint32_t>(relative * _STRATIFICATION_GRID_SIZE_));
+
+            cell = cell * _STRATIFICATION_GRID_SIZE_ + index;
+        }
+
+        return cell;
+    };
+
+    // Rank of every point within its cell in a pseudo-random order
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> order(numPoints);
+
+    for (std::uint32_t point = 0; point < numPoints; point++)
+        order[point] = { (static_cast<std::uint64_t>(cellOf(point)) << 32) | (hashPoint(point) >> 32), point };
+
+    std::sort(order.begin(), order.end());
+
+    std::vector<std::uint32_t> rank(numPoints);
+
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        const bool newCell = i == 0 || (order[i].first >> 32) != (order[i - 1].first >> 32);
+        rank[order[i].second] = newCell ? 0 : rank[order[i - 1].second] + 1;
+    }
+
+    // Level k keeps the points whose rank is a multiple of 2^k, thereby each level is a subset of the previous one and every occupied cell keeps a point
+    for (std::uint32_t stride = 2; ; stride *= 2)
+    {
+        std::vector<std::uint32_t> level;
+
+        for (std::uint32_t point = 0; point < numPoints; point++)
+            if (rank[point] % stride == 0)
+                level.push_back(point);
+
+        // Once most cells are down to a single point the levels stop shrinking
+        if (level.size() < _MIN_LEVEL_POINTS_ || 10 * level.size() > 9 * _pointLevels.back().size())
+            break;
+
+        _pointLevels.push_back(std::move(level));
+    }
+}
+
+std::pair<std::uint32_t, std::uint32_t> TrajectoryPyramid::findLevels(std::size_t maxValues) const
+{
+    if (empty())
+        return { 0, 0 };
+
+    // Coarsen time first, then the points
+    for (std::uint32_t pointLevel = 0; pointLevel < getNumPointLevels(); pointLevel++)
+        for (std::uint32_t timeLevel = 0; timeLevel < getNumTimeLevels(); timeLevel++)
+            if (_pointLevels[pointLevel].size() * _timeLevels[timeLevel].size() * _numDimensions <= maxValues)
+                return { pointLevel, timeLevel };
+
+    return { getNumPointLevels() - 1, getNumTimeLevels() - 1 };
+}
+
+std::vector<float> TrajectoryPyramid::extract(const Trajectory& trajectory, std::uint32_t pointLevel, std::uint32_t timeLevel) const
+{
+    assert(pointLevel < getNumPointLevels() && timeLevel < getNumTimeLevels());
+
+    const auto& points = _pointLevels[pointLevel];
+    const auto& timesteps = _timeLevels[timeLevel];
+
+    const std::size_t pointStride = timesteps.size() * _numDimensions;
+
+    std::vector<float> records(points.size() * pointStride);
+
+#pragma omp parallel for schedule(static)
+    for (std::int64_t i = 0; i < static_cast<std::int64_t>(points.size()); i++)
+        trajectory.copyPointTrajectory(points[i], timesteps, records.data() + i * pointStride);
+
+    return records;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class Trajectory;
+
+/**
+ * TrajectoryPyramid
+ *
+ * Multi-resolution index over a recorded trajectory. Every temporal level keeps every other timestep of
+ * the previous level (and always the last one), every point level keeps about half of the points of the
+ * previous level. The point levels are stratified spatially: the points are binned in a grid over the
+ * last recorded embedding and thinned per cell, such that sparse regions keep their points.
+ * The levels only hold indices, the values are extracted from the trajectory on request.
+ */
+class TrajectoryPyramid
+{
+public:
+    TrajectoryPyramid();
+
+    /** Build the levels of a trajectory, replaces previous levels */
+    void build(const Trajectory& trajectory);
+
+    /** Remove all levels */
+    void clear();
+
+    bool empty() const { return _pointLevels.empty(); }
+
+    /** Level 0 holds all points respectively timesteps */
+    std::uint32_t getNumPointLevels() const { return static_cast<std::uint32_t>(_pointLevels.size()); }
+    std::uint32_t getNumTimeLevels() const { return static_cast<std::uint32_t>(_timeLevels.size()); }
+
+    /** Ascending point indices of a point level */
+    const std::vector<std::uint32_t>& getPointIndices(std::uint32_t pointLevel) const { return _pointLevels[pointLevel]; }
+
+    /** Ascending timestep indices of a temporal level */
+    const std::vector<std::uint32_t>& getTimesteps(std::uint32_t timeLevel) const { return _timeLevels[timeLevel]; }
+
+    /**
+     * Finest combination of levels that fits a budget, the number of points is reduced last
+     * @param maxValues Maximum number of values of the extracted records
+     * @return Point level and temporal level
+     */
+    std::pair<std::uint32_t, std::uint32_t> findLevels(std::size_t maxValues) const;
+
+    /**
+     * Point-major records of a level: for every point of the point level its positions at the timesteps of the temporal level,
+     * with the normalization of the trajectory
+     * @param trajectory Trajectory the pyramid was built from
+     * @param pointLevel Point level
+     * @param timeLevel Temporal level
+     * @return Records, numPoints(pointLevel) * numTimesteps(timeLevel) * numDimensions values
+     */
+    std::vector<float> extract(const Trajectory& trajectory, std::uint32_t pointLevel, std::uint32_t timeLevel) const;
+
+private:
+    void buildPointLevels(const Trajectory& trajectory);
+    void buildTimeLevels(const Trajectory& trajectory);
+
+private:
+    std::uint32_t                               _numDimensions;     /** Number of values per point and timestep */
+    std::vector<std::vector<std::uint32_t>>     _pointLevels;       /** Point indices per point level */
+    std::vector<std::vector<std::uint32_t>>     _timeLevels;        /** Timestep indices per temporal level */
+};
@@ -0,0 +1,117 @@
+#include "TrajectoryStatistics.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+    // A step counts towards the stabilization iteration if it is longer than this fraction of the longest step of the point
+    constexpr float _STABILIZATION_FRACTION_ = 0.01f;
+}
+
+const std::vector<std::string>& TrajectoryStatistics::getNames()
+{
+    static const std::vector<std::string> names = { "Path length", "Mean velocity", "Stabilization iteration", "Max displacement" };
+    return names;
+}
+
+TrajectoryStatistics::TrajectoryStatistics() :
+    _numPoints(0),
+    _numDimensions(0),
+    _numSteps(0),
+    _hasStart(false),
+    _start(),
+    _previous(),
+    _pathLength(),
+    _maxStep(),
+    _maxDisplacement(),
+    _stabilizationIteration()
+{
+}
+
+void TrajectoryStatistics::reset(std::uint32_t numPoints, std::uint32_t numDimensions)
+{
+    _numPoints = numPoints;
+    _numDimensions = numDimensions;
+    _numSteps = 0;
+    _hasStart = false;
+
+    _start.assign(static_cast<std::size_t>(numPoints) * numDimensions, 0.f);
+    _previous.assign(static_cast<std::size_t>(numPoints) * numDimensions, 0.f);
+    _pathLength.assign(numPoints, 0.f);
+    _maxStep.assign(numPoints, 0.f);
+    _maxDisplacement.assign(numPoints, 0.f);
+    _stabilizationIteration.assign(numPoints, 0);
+}
+
+void TrajectoryStatistics::update(const float* embedding, int iteration)
+{
+    assert(embedding != nullptr || _numPoints == 0);
+
+    const std::size_t numValues = static_cast<std::size_t>(_numPoints) * _numDimensions;
+
+    if (!_hasStart)
+    {
+        std::copy_n(embedding, numValues, _start.begin());
+        std::copy_n(embedding, numValues, _previous.begin());
+
+        _hasStart = true;
+        return;
+    }
+
+    const std::int64_t numDimensions = _numDimensions;
+
+#pragma omp parallel for schedule(static)
+    for (std::int64_t point = 0; point < static_cast<std::int64_t>(_numPoints); point++)
+    {
+        const float* current = embedding + point * numDimensions;
+        float* previous = _previous.data() + point * numDimensions;
+        const float* start = _start.data() + point * numDimensions;
+
+        float stepSquared = 0.f;
+        float displacementSquared = 0.f;
+
+        for (std::int64_t d = 0; d < numDimensions; d++)
+        {
+            const float step = current[d] - previous[d];
+            const float displacement = current[d] - start[d];
+
+            stepSquared += step * step;
+            displacementSquared += displacement * displacement;
+
+            previous[d] = current[d];
+        }
+
+        const float step = std::sqrt(stepSquared);
+
+        _pathLength[point] += step;
+        _maxStep[point] = std::max(_maxStep[point], step);
+        _maxDisplacement[point] = std::max(_maxDisplacement[point], std::sqrt(displacementSquared));
+
+        if (step > _STABILIZATION_FRACTION_ * _maxStep[point])
+            _stabilizationIteration[point] = iteration;
+    }
+
+    _numSteps++;
+}
+
+std::vector<float> TrajectoryStatistics::getStatistics() const
+{
+    std::vector<float> statistics(static_cast<std::size_t>(_numPoints) * NumStatistics);
+
+    const float numSteps = static_cast<float>(std::max<std::uint32_t>(1, _numSteps));
+
+#pragma omp parallel for schedule(static)
+    for (std::int64_t point = 0; point < static_cast<std::int64_t>(_numPoints); point++)
+    {
+        float* pointStatistics = statistics.data() + point * NumStatistics;
+
+        pointStatistics[PathLength] = _pathLength[point];
+        pointStatistics[MeanVelocity] = _pathLength[point] / numSteps;
+        pointStatistics[StabilizationIteration] = static_cast<float>(_stabilizationIteration[point]);
+        pointStatistics[MaxDisplacement] = _maxDisplacement[point];
+    }
+
+    return statistics;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * TrajectoryStatistics
+ *
+ * Per-point summaries of the embeddings over the iterations of a gradient descent, accumulated online
+ * after every iteration with a constant amount of memory per point, such that they are available
+ * without recording the full trajectory.
+ */
+class TrajectoryStatistics
+{
+public:
+    /** Statistics per point, in the order of getStatistics() */
+    enum Statistic
+    {
+        PathLength,                 /** Summed distance between consecutive iterations */
+        MeanVelocity,               /** Path length per iteration */
+        StabilizationIteration,     /** Iteration of the last step that was longer than a fraction of the largest step of the point */
+        MaxDisplacement,            /** Largest distance from the position before the first update */
+
+        NumStatistics
+    };
+
+    /** Names of the statistics, in the order of the Statistic enum */
+    static const std::vector<std::string>& getNames();
+
+public:
+    TrajectoryStatistics();
+
+    /** Restart the accumulation */
+    void reset(std::uint32_t numPoints, std::uint32_t numDimensions);
+
+    /**
+     * Accumulate an iteration, the first call after a reset only sets the start positions
+     * @param embedding Point-major embedding, numPoints * numDimensions values
+     * @param iteration Gradient descent iteration of the embedding
+     */
+    void update(const float* embedding, int iteration);
+
+    std::uint32_t getNumPoints() const { return _numPoints; }
+    std::uint32_t getNumDimensions() const { return _numDimensions; }
+    std::uint32_t getNumSteps() const { return _numSteps; }
+
+    /** Point-major statistics, NumStatistics values per point */
+    std::vector<float> getStatistics() const;
+
+private:
+    std::uint32_t       _numPoints;                 /** Number of points */
+    std::uint32_t       _numDimensions;             /** Number of embedding dimensions */
+    std::uint32_t       _numSteps;                  /** Number of accumulated steps */
+    bool                _hasStart;                  /** Whether the start positions are set */
+    std::vector<float>  _start;                     /** Positions before the first step */
+    std::vector<float>  _previous;                  /** Positions of the last update */
+    std::vector<float>  _pathLength;                /** Accumulated path length per point */
+    std::vector<float>  _maxStep;                   /** Longest step per point */
+    std::vector<float>  _maxDisplacement;           /** Largest distance from the start per point */
+    std::vector<int>    _stabilizationIteration;    /** Iteration of the last long step per point */
+};
@@ -1,9 +1,19 @@
 #include "TsneAnalysis.h"
 
 #include "hdi/utils/glad/glad.h"
+#include "GradientDescentProgress.h"
+#include "KnnSimilarities.h"
 #include "OffscreenBuffer.h"
+#include "RandomizedPca.h"
+#include "TrajectoryBudget.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <future>
 #include <vector>
 
 #include <QCoreApplication>
@@ -13,21 +23,138 @@
 
 using namespace mv;
 
+namespace
+{
+    // Rows of the probability distribution that are handed to a thread at once
+    constexpr std::int64_t _SYMMETRIZE_BLOCK_SIZE_ = 256;
+
+    // Wall-clock interval of progress reports and embedding updates during the gradient descent
+    constexpr auto _REPORT_INTERVAL_ = std::chrono::milliseconds(100);
+
+    // Phases of the worker profile, added in this order
+    enum WorkerPhase : PhaseProfiler::PhaseId
+    {
+        SimilaritiesPhase,
+        PcaInitializationPhase,
+        InitializeGradientDescentPhase,
+        GradientDescentStepPhase,
+        RecordTrajectoryPhase,
+        UpdateEmbeddingPhase,
+        ReportProgressPhase,
+        FinalizeTrajectoryPhase
+    };
+
+    /**
+     * P = (P + P^T) / 2 over the union of both sparsity patterns, same as the symmetrization of the
+     * joint probability generator but in parallel row blocks: the transpose is gathered column-wise
+     * first, afterwards every row is merged with its column independently of the other rows.
+     * Once cancelled the remaining rows are skipped, the distribution is incomplete then
+     */
+    void symmetrizeInParallel(ProbDistMatrix& distribution, const CancellationToken& cancellation)
+    {
+        const std::int64_t numRows = static_cast<std::int64_t>(distribution.size());
+
+        // Number of entries per column, as offsets into the transposed entries
+        std::vector<std::atomic<std::uint32_t>> columnCounts(numRows);
+        for (auto& count : columnCounts)
+            count.store(0, std::memory_order_relaxed);
+
+#pragma omp parallel for schedule(dynamic, _SYMMETRIZE_BLOCK_SIZE_)
+        for (std::int64_t row = 0; row < numRows; row++)
+        {
+            if (cancellation.isCancelled())
+                continue;
+
+            for (const auto& entry : distribution[row])
+                columnCounts[entry.first].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (cancellation.isCancelled())
+            return;
+
+        std::vector<std::uint64_t> columnOffsets(numRows + 1, 0);
+        for (std::int64_t column = 0; column < numRows; column++)
+            columnOffsets[column + 1] = columnOffsets[column] + columnCounts[column].load(std::memory_order_relaxed);
+
+        for (std::int64_t column = 0; column < numRows; column++)
+            columnCounts[column].store(0, std::memory_order_relaxed);
+
+        std::vector<std::pair<std::uint32_t, float>> transposed(columnOffsets.back());
+
+#pragma omp parallel for schedule(dynamic, _SYMMETRIZE_BLOCK_SIZE_)
+        for (std::int64_t row = 0; row < numRows; row++)
+        {
+            if (cancellation.isCancelled())
+                continue;
+
+            for (const auto& entry : distribution[row])
+                transposed[columnOffsets[entry.first] + columnCounts[entry.first].fetch_add(1, std::memory_order_relaxed)] = { static_cast<std::uint32_t>(row), entry.second };
+        }
+
+        if (cancellation.isCancelled())
+            return;
+
+#pragma omp parallel for schedule(dynamic, _SYMMETRIZE_BLOCK_SIZE_)
+        for (std::int64_t row = 0; row < numRows; row++)
+        {
+            if (cancellation.isCancelled())
+                continue;
+
+            // Entries of column row, i.e. P^T[row], sorted by their row like the entries of P[row]
+            const auto columnBegin = transposed.begin() + columnOffsets[row];
+            const auto columnEnd = transposed.begin() + columnOffsets[row + 1];
+            std::sort(columnBegin, columnEnd, [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+            auto& rowEntries = distribution[row].memory();
+
+            std::vector<std::pair<std::uint32_t, float>> merged;
+            merged.reserve(rowEntries.size() + static_cast<size_t>(columnEnd - columnBegin));
+
+            auto rowIt = rowEntries.cbegin();
+            auto columnIt = columnBegin;
+
+            while (rowIt != rowEntries.cend() || columnIt != columnEnd)
+            {
+                if (columnIt == columnEnd || (rowIt != rowEntries.cend() && rowIt->first < columnIt->first))
+                {
+                    merged.emplace_back(rowIt->first, rowIt->second * 0.5f);
+                    ++rowIt;
+                }
+                else if (rowIt == rowEntries.cend() || columnIt->first < rowIt->first)
+                {
+                    merged.emplace_back(columnIt->first, columnIt->second * 0.5f);
+                    ++columnIt;
+                }
+                else
+                {
+                    merged.emplace_back(rowIt->first, (rowIt->second + columnIt->second) * 0.5f);
+                    ++rowIt;
+                    ++columnIt;
+                }
+            }
+
+            rowEntries.assign(merged.begin(), merged.end());
+        }
+    }
+}
+
 TsneWorker::TsneWorker(TsneParameters tsneParameters) :
     _currentIteration(0),
     _tsneParameters(tsneParameters),
     _knnParameters(),
     _numPoints(0),
     _numDimensions(0),
-    _data(),
+    _input(),
     _probabilityDistribution(),
+    _sharedProbabilityDistribution(),
     _hasProbabilityDistribution(false),
     _GPGPU_tSNE(),
     _CPU_tSNE(),
     _embedding(),
     _outEmbedding(),
     _offscreenBuffer(nullptr),
-    _shouldStop(false),
+    _cancellation(),
+    _profiler("TSNE worker", { "Similarities", "PCA initialization", "Initialize gradient descent", "Gradient descent step", "Record trajectory", "Update embedding", "Report progress", "Finalize trajectory" }),
     _parentTask(nullptr),
     _tasks(nullptr)
 {
@@ -36,27 +163,23 @@ TsneWorker::TsneWorker(TsneParameters tsneParameters) :
 }
 
 TsneWorker::TsneWorker(TsneParameters tsneParameters, KnnParameters knnParameters, const std::vector<float>& data, uint32_t numDimensions, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding) :
-    TsneWorker(tsneParameters)
+    TsneWorker(tsneParameters, knnParameters, TsneInputData(std::vector<float>(data), numDimensions), initEmbedding)
 {
-    _knnParameters = knnParameters;
-    assert(numDimensions > 0);
-    _numPoints = data.size() / numDimensions;
-    _numDimensions = numDimensions;
-    _data = data;
-    _embedding = { static_cast<uint32_t>(_tsneParameters.getNumDimensionsOutput()), _numPoints };
-
-    if (initEmbedding)
-        setInitEmbedding(*initEmbedding);
 }
 
 TsneWorker::TsneWorker(TsneParameters parameters, KnnParameters knnParameters, std::vector<float>&& data, uint32_t numDimensions, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding) :
+    TsneWorker(parameters, knnParameters, TsneInputData(std::move(data), numDimensions), initEmbedding)
+{
+}
+
+TsneWorker::TsneWorker(TsneParameters parameters, KnnParameters knnParameters, TsneInputData&& input, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding) :
     TsneWorker(parameters)
 {
     _knnParameters = knnParameters;
-    assert(numDimensions > 0);
-    _numPoints = data.size() / numDimensions;
-    _numDimensions = numDimensions;
-    _data = std::move(data);
+    assert(input.getNumDimensions() > 0);
+    _numPoints = input.getNumPoints();
+    _numDimensions = input.getNumDimensions();
+    _input = std::move(input);
     _embedding = { static_cast<uint32_t>(_tsneParameters.getNumDimensionsOutput()), _numPoints };
 
     if (initEmbedding)
@@ -88,6 +211,19 @@ TsneWorker::TsneWorker(TsneParameters parameters, std::vector<hdi::data::MapMemE
         setInitEmbedding(*initEmbedding);
 }
 
+TsneWorker::TsneWorker(TsneParameters parameters, std::shared_ptr<const ProbDistMatrix> jointProbDist, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding) :
+    TsneWorker(parameters)
+{
+    assert(jointProbDist);
+    _sharedProbabilityDistribution = std::move(jointProbDist);
+    _hasProbabilityDistribution = true;
+    _numPoints = static_cast<uint32_t>(_sharedProbabilityDistribution->size());
+    _embedding = { static_cast<uint32_t>(_tsneParameters.getNumDimensionsOutput()), _numPoints };
+
+    if (initEmbedding)
+        setInitEmbedding(*initEmbedding);
+}
+
 TsneWorker::~TsneWorker()
 {
     delete _offscreenBuffer;
@@ -105,6 +241,10 @@ void TsneWorker::changeThread(QThread* targetThread)
 
 void TsneWorker::resetThread()
 {
+    // The next job of this worker might run in another pool thread, which can only bind a context that is not current here
+    if (_offscreenBuffer->getContext())
+        _offscreenBuffer->releaseContext();
+
     changeThread(QCoreApplication::instance()->thread());
 }
 
@@ -113,6 +253,14 @@ int TsneWorker::getNumIterations() const
     return _currentIteration + 1;
 }
 
+bool TsneWorker::canContinue()
+{
+    if (_tsneParameters.getGradientDescentType() == GradientDescentType::GPU)
+        return _GPGPU_tSNE.isInitialized();
+
+    return _CPU_tSNE.isInitialized();
+}
+
 void TsneWorker::setParentTask(mv::Task* parentTask)
 {
     _parentTask = parentTask;
@@ -150,6 +298,10 @@ void TsneWorker::setCurrentIteration(int currentIteration)
 
 void TsneWorker::createTasks()
 {
+    // The similarities of a shared probability distribution are computed before the gradient descent is started
+    if (_tasks)
+        return;
+
     _tasks = new TsneWorkerTasks(this, _parentTask);
 }
 
@@ -185,11 +337,14 @@ hdi::dr::HDJointProbabilityGenerator<float>::Parameters TsneWorker::probGenParam
 
 void TsneWorker::computeSimilarities()
 {
-    assert(_data.size() == _numDimensions * _numPoints);
+    assert(_input.size() == static_cast<size_t>(_numDimensions) * _numPoints);
 
     _tasks->getComputingSimilaritiesTask().setRunning();
 
+    PhaseProfiler::ScopedPhase phase(&_profiler, SimilaritiesPhase);
+
     double t = 0.0;
+    double t_symmetrize = 0.0;
     {
         hdi::utils::ScopedTimer<double> timer(t);
 
@@ -197,22 +352,100 @@ void TsneWorker::computeSimilarities()
         _probabilityDistribution.resize(_numPoints);
         qDebug() << "Sparse matrix allocated.";
 
-        hdi::dr::HDJointProbabilityGenerator<float> probabilityGenerator;
+        const auto probGenParams = probGenParameters();
 
         qDebug() << "Computing high dimensional probability distributions: Num dims: " << _numDimensions << " Num data points: " << _numPoints;
-        probabilityGenerator.computeJointProbabilityDistribution(_data.data(), _numDimensions, _numPoints, _probabilityDistribution, probGenParameters());         // The _probabilityDistribution is symmetrized here.
+
+        if (KnnSimilarities::isSupported(_knnParameters))
+        {
+            // Queried in batches of points, a stop takes effect after the current batch
+            const auto numNeighbors = static_cast<uint32_t>(probGenParams._perplexity * probGenParams._perplexity_multiplier + 1);
+
+            KnnSimilarities(_knnParameters, numNeighbors, probGenParams._perplexity).compute(_input.data(), _numPoints, _numDimensions, _probabilityDistribution, _cancellation);
+        }
+        else
+        {
+            qDebug() << "tSNE: The nearest neighbours of this library and metric are searched by HDI at once, a stop takes effect once the search has finished";
+
+            hdi::dr::HDJointProbabilityGenerator<float> probabilityGenerator;
+
+            // The generator only reads the data but does not take a const pointer
+            // It cannot be interrupted, a stop requested meanwhile takes effect when it returns
+            probabilityGenerator.computeProbabilityDistributions(const_cast<float*>(_input.data()), _numDimensions, _numPoints, _probabilityDistribution, probGenParams);
+        }
+
+        if (!_cancellation.isCancelled())
+        {
+            // The generator symmetrizes row by row in a single thread, this is the same joint distribution computed in parallel
+            hdi::utils::ScopedTimer<double> symmetrizeTimer(t_symmetrize);
+            symmetrizeInParallel(_probabilityDistribution, _cancellation);
+        }
     }
-    
+
+    // An incomplete distribution is of no use, release its memory right away
+    if (_cancellation.isCancelled())
+    {
+        ProbDistMatrix().swap(_probabilityDistribution);
+
+        qDebug() << "tSNE: Stopped the computation of the probability distribution";
+
+        _tasks->getComputingSimilaritiesTask().setAborted();
+        return;
+    }
+
     qDebug() << "================================================================================";
-    qDebug() << "tSNE: Computed probability distribution: " << t / 1000 << " seconds";
+    qDebug() << "tSNE: Computed probability distribution: " << t / 1000 << " seconds (symmetrization: " << t_symmetrize / 1000 << " seconds)";
     qDebug() << "--------------------------------------------------------------------------------";
 
     _tasks->getComputingSimilaritiesTask().setFinished();
 }
 
+void TsneWorker::computePcaInitEmbedding()
+{
+    const auto numComponents = static_cast<uint32_t>(_tsneParameters.getNumDimensionsOutput());
+
+    if (_cancellation.isCancelled())
+        return;
+
+    PhaseProfiler::ScopedPhase phase(&_profiler, PcaInitializationPhase);
+
+    std::vector<float> projection;
+
+    double t = 0.0;
+    {
+        hdi::utils::ScopedTimer<double> timer(t);
+
+        RandomizedPca pca(numComponents);
+        projection = pca.computeProjection(_input.data(), _numPoints, _numDimensions);
+    }
+
+    if (projection.empty())
+    {
+        qWarning() << "tSNE: PCA initialization needs at least " << numComponents << " input dimensions, keeping the initial embedding";
+        return;
+    }
+
+    // Same scale as the other init embeddings: standard deviation of the first component is 0.0001, relative variances are kept
+    const float stdevDesired = 0.0001f;
+
+    double sumSquares = 0.0;
+    for (uint32_t i = 0; i < _numPoints; i++)
+        sumSquares += static_cast<double>(projection[i * numComponents]) * projection[i * numComponents];
+
+    const double stdevCurrent = std::sqrt(sumSquares / _numPoints);
+
+    if (stdevCurrent > 0.0)
+        for (auto& value : projection)
+            value = static_cast<float>(value * (stdevDesired / stdevCurrent));
+
+    setInitEmbedding(projection);
+
+    qDebug() << "tSNE: Computed PCA initialization in " << t / 1000 << " seconds.";
+}
+
 void TsneWorker::computeGradientDescent(uint32_t iterations)
 {
-    if (_shouldStop)
+    if (_cancellation.isCancelled())
         return;
 
     //const auto updateEmbedding = [this](const TsneData& tsneData) -> void {
@@ -222,6 +455,7 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
     //    qDebug() << "tSNE: Updated embedding.";
     //    };
     const auto updateEmbedding = [this](const std::vector<float>& data, const int numPoints, const int numDismensions) -> void {
+        PhaseProfiler::ScopedPhase phase(&_profiler, UpdateEmbeddingPhase);
         copyEmbeddingOutput();
         //emit embeddingUpdate(tsneData);
         emit embeddingUpdate(data, numPoints, numDismensions);
@@ -242,7 +476,9 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
             auto params = tsneParameters();
 
             // In case of HSNE, the _probabilityDistribution is a non-summetric transition matrix and initialize() symmetrizes it here
-            if (_hasProbabilityDistribution)
+            if (_sharedProbabilityDistribution)
+                _GPGPU_tSNE.initializeWithJointProbabilityDistribution(*_sharedProbabilityDistribution, &_embedding, params);
+            else if (_hasProbabilityDistribution)
                 _GPGPU_tSNE.initialize(_probabilityDistribution, &_embedding, params);
             else
                 _GPGPU_tSNE.initializeWithJointProbabilityDistribution(_probabilityDistribution, &_embedding, params);
@@ -260,7 +496,11 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
             _CPU_tSNE.setTheta(theta);
 
             // In case of HSNE, the _probabilityDistribution is a non-summetric transition matrix and initialize() symmetrizes it here
-            if (_hasProbabilityDistribution) {
+            if (_sharedProbabilityDistribution) {
+                qDebug() << "CPU t-SNE: Initialize with shared joint probability distribution";
+                _CPU_tSNE.initializeWithJointProbabilityDistribution(*_sharedProbabilityDistribution, &_embedding, params);
+            }
+            else if (_hasProbabilityDistribution) {
                 qDebug() << "CPU t-SNE: Initialize with probability distribution";
                 _CPU_tSNE.initialize(_probabilityDistribution, &_embedding, params);
             }
@@ -277,6 +517,7 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
         double t_init = 0.0;
         {
             hdi::utils::ScopedTimer<double> timer(t_init);
+            PhaseProfiler::ScopedPhase phase(&_profiler, InitializeGradientDescentPhase);
 
             if (_tsneParameters.getGradientDescentType() == GradientDescentType::GPU)
                 initGPUTSNE();
@@ -290,6 +531,8 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
     };
 
     auto singleTSNEIteration = [this]() {
+        PhaseProfiler::ScopedPhase phase(&_profiler, GradientDescentStepPhase);
+
         if (_tsneParameters.getGradientDescentType() == GradientDescentType::GPU)
             _GPGPU_tSNE.doAnIteration();
         else
@@ -312,9 +555,54 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
     const auto beginIteration = _currentIteration;
     const auto endIteration = beginIteration + iterations;
     qDebug() << "tSNE: Begin iteration: " << beginIteration << ", End iteration: " << endIteration;
-    // clear _allEmbeddings if beginIteration == 0
-    if (beginIteration == 0)
-        _allEmbeddings.clear();
+    // Restart the recording unless the computation is continued
+    if (beginIteration == 0 || _trajectory.getNumPoints() != _numPoints)
+    {
+        _trajectory.reset(_numPoints, 2);
+        _alignment.reset();
+    }
+
+    // The levels of detail are rebuilt from the new recording when they are requested
+    _trajectoryPyramid.clear();
+
+    bool recordTrajectory = _tsneParameters.getRecordTrajectory();
+    int subSampleFactor = _tsneParameters.getSubsampleFactor();
+
+    // Adapt the recording to the memory budget now instead of running out of memory when the trajectory is published
+    if (recordTrajectory)
+    {
+        const TrajectoryBudget budget(static_cast<std::size_t>(_tsneParameters.getTrajectoryMemoryBudget()) << 20);
+        const auto plan = budget.plan(_trajectory, beginIteration, endIteration, subSampleFactor, _tsneParameters.getTrajectoryWindow() == 0);
+        const auto description = QString::fromStdString(TrajectoryBudget::describe(plan));
+
+        if (plan.policy == TrajectoryBudget::Policy::StatisticsOnly)
+            recordTrajectory = false;
+        else
+        {
+            subSampleFactor = plan.subsampleFactor;
+            _trajectory.setPrecision(plan.precision);
+        }
+
+        if (plan.policy == TrajectoryBudget::Policy::None)
+            qDebug() << "tSNE: Trajectory memory: " << description;
+        else
+            qWarning() << "tSNE: Trajectory recording exceeds the memory budget, adapted to: " << description;
+
+        emit trajectoryBudgetUpdate(description);
+    }
+    else
+        emit trajectoryBudgetUpdate("Statistics only");
+
+    const bool computeStatistics = _tsneParameters.getTrajectoryStatistics() || !recordTrajectory;
+    const auto numOutputDimensions = static_cast<std::uint32_t>(_tsneParameters.getNumDimensionsOutput());
+    // Rotating 1D records would mix the iteration axis into the embedding
+    const bool alignSnapshots = _tsneParameters.getAlignSnapshots() && numOutputDimensions == 2;
+
+    if (computeStatistics && (beginIteration == 0 || _trajectoryStatistics.getNumPoints() != _numPoints || _trajectoryStatistics.getNumDimensions() != numOutputDimensions))
+    {
+        _trajectoryStatistics.reset(_numPoints, numOutputDimensions);
+        _trajectoryStatistics.update(_embedding.getContainer().data(), beginIteration);
+    }
 
     double elapsed = 0;
     double t_grad = 0;
@@ -326,23 +614,26 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
         //else {
         //    updateEmbedding(_embedding1D, _outEmbedding.getNumPoints(), 2);
         //}
-        int subSampleFactor = _tsneParameters.getSubsampleFactor();
-
         _tasks->getComputeGradientDescentTask().setRunning();
-        _tasks->getComputeGradientDescentTask().setSubtasks(iterations);
 
-        int currentStepIndex = 0;
+        // A bounded number of subtasks over the optimization phases, independent of the number of iterations
+        GradientDescentProgress progress;
+        progress.start(_tasks->getComputeGradientDescentTask(), beginIteration, endIteration, _tsneParameters.getExaggerationIter(), _tsneParameters.getExaggerationIter() + _tsneParameters.getExponentialDecayIter());
+
+        // Iterations of small embeddings take far less time than a progress report, report at a fixed cadence instead
+        auto lastReport = std::chrono::steady_clock::now();
 
         // Performs gradient descent for every iteration
         for (_currentIteration = beginIteration; _currentIteration < endIteration; ++_currentIteration) {
             //qDebug() << "update every: " << _tsneParameters.getUpdateCore();
             //_embedding1D.clear();
-            _tasks->getComputeGradientDescentTask().setSubtaskStarted(currentStepIndex);
-
             hdi::utils::ScopedTimer<double> timer(t_grad);
 
             // Perform t-SNE iteration
             singleTSNEIteration();
+
+            // The recording reads the embedding of this iteration
+            copyEmbeddingOutput();
             //qDebug() << "tSNE: Iteration " << _currentIteration << " done.";
             //qDebug() << "output size: " << _outEmbedding.getData().size() << ", numPoints: " << _outEmbedding.getNumPoints();
             /*if (_currentIteration > 0 && _tsneParameters.getUpdateCore() > 0 && _currentIteration % _tsneParameters.getUpdateCore() == 0)
@@ -350,6 +641,8 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
             
             int numDim = _outEmbedding.getData().size() / _outEmbedding.getNumPoints();
             std::vector<float> embedding2D;
+            const auto recordStart = PhaseProfiler::Clock::now();
+
             if (numDim == 1) {
                 // for 1D t-SNE, fill the x axis with float valued current timestep and y asis with _outEmbedding data
                 for (int i = 0; i < _outEmbedding.getNumPoints(); i++)
@@ -358,100 +651,102 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
                     embedding2D.push_back(_outEmbedding.getData()[i]);
                 }
                 //_embedding1D.insert(_embedding1D.end(), embedding2D.begin(), embedding2D.end());
-                // if currentStepIndex divides the current iteration, append the current embedding to _allEmbeddings
-                if (_currentIteration % subSampleFactor == 0)
-                    _allEmbeddings.insert(_allEmbeddings.end(), embedding2D.begin(), embedding2D.end());
+                // if currentStepIndex divides the current iteration, record the current embedding
+                if (recordTrajectory && _currentIteration % subSampleFactor == 0)
+                    _trajectory.append(embedding2D.data(), _currentIteration);
             }
             else {
-                // if currentStepIndex divides the current iteration, append the current embedding to _allEmbeddings
-                if (_currentIteration % subSampleFactor == 0)
-                    _allEmbeddings.insert(_allEmbeddings.end(), _outEmbedding.getData().begin(), _outEmbedding.getData().end());
-            }
-            //qDebug() << "allEmbeddings size: " << _allEmbeddings.size();
+                // if currentStepIndex divides the current iteration, record the current embedding
+                if (recordTrajectory && _currentIteration % subSampleFactor == 0)
+                {
+                    const float* snapshot = _outEmbedding.getData().data();
+
+                    if (alignSnapshots)
+                        snapshot = _alignment.align(snapshot, _numPoints);
 
-            if (numDim == 2) {
-                updateEmbedding(_outEmbedding.getData(), _outEmbedding.getNumPoints(), 2); // if not update in during the iteration, the record will be incorrect
+                    _trajectory.append(snapshot, _currentIteration);
+                }
             }
-            else {
-                updateEmbedding(embedding2D, _outEmbedding.getNumPoints(), 2);
+
+            if (computeStatistics)
+                _trajectoryStatistics.update(_outEmbedding.getData().data(), _currentIteration);
+
+            _profiler.record(RecordTrajectoryPhase, recordStart, PhaseProfiler::Clock::now());
+
+            const auto now = std::chrono::steady_clock::now();
+
+            // The last iteration is always published, it is the output unless the whole trajectory is
+            if (now - lastReport >= _REPORT_INTERVAL_ || _currentIteration + 1 == endIteration || _cancellation.isCancelled())
+            {
+                lastReport = now;
+
+                {
+                    PhaseProfiler::ScopedPhase phase(&_profiler, UpdateEmbeddingPhase);
+                    emit embeddingUpdate(numDim == 2 ? _outEmbedding.getData() : embedding2D, _outEmbedding.getNumPoints(), 2);
+                }
+
+                PhaseProfiler::ScopedPhase phase(&_profiler, ReportProgressPhase);
+
+                progress.update(_currentIteration);
+
+                // Other analyses might have started or finished in the meantime
+                EmbeddingScheduler::instance().applyThreadShare();
             }
-            //updateEmbedding(_outEmbedding.getData(), _outEmbedding.getNumPoints(), _outEmbedding.getData().size() / _outEmbedding.getNumPoints()); // if not update in during the iteration, the record will be incorrect
-            
 
             if (t_grad > 1000)
                 qDebug() << "Time: " << t_grad;
 
             elapsed += t_grad;
 
-            // React to requests to stop
-            if (_shouldStop)
+            // React to requests to stop, the token is cancelled from other threads
+            if (_cancellation.isCancelled())
                 break;
-            
-            _tasks->getComputeGradientDescentTask().setSubtaskFinished(currentStepIndex);
-
-            currentStepIndex++;
-
-            QCoreApplication::processEvents();
         }
 
         gradientDescentCleanup();
         qDebug() << "tSNE: Finished gradient descent, now prepare all t-SNE records.";
-        //qDebug() << "_allEmbeddings size: " << _allEmbeddings.size();
-        //qDebug() << "_outEmbedding numpoints: " << _outEmbedding.getNumPoints() << ", size: " << _outEmbedding.getData().size();
-
         //qDebug() << "output embedding size: " << _outEmbedding.getData().size() << ", numPoints: " << _outEmbedding.getNumPoints();
         //updateEmbedding(_outEmbedding.getData(), _outEmbedding.getNumPoints(), _outEmbedding.getData().size() / _outEmbedding.getNumPoints());
         
-        // define a new vector to store the transposed data, so that embeddings are not organized as [x(i0,t0), y(x0,t0), x(i1,t0), y(i1,t0), ...] but as [x(i0,t0), y(i0,t0), x(i0, t1), y(i0,t1), ...]
-        std::vector<float> dataTransposed; 
-        int numOutputDim = _outEmbedding.getData().size() / _outEmbedding.getNumPoints();
-        int numTimesteps; // = _allEmbeddings.size() / _outEmbedding.getData().size();
-        if (numOutputDim == 2)
-            numTimesteps = _allEmbeddings.size() / _outEmbedding.getData().size();
-        else
-            numTimesteps = _allEmbeddings.size() / (_outEmbedding.getData().size() * 2);
-        
-        for (int i = 0; i < _outEmbedding.getNumPoints(); i++)
+        // Without a recording the output keeps the embedding of the last iteration.
+        // A computation stopped during the gradient descent publishes the iterations recorded so far, only a stop during the publishing skips it
+        const bool stoppedBeforeFinalization = _cancellation.isCancelled();
+
+        if (recordTrajectory && !_trajectory.empty())
         {
-            for (int j = 0; j < numTimesteps; j++)
-            {   
-                dataTransposed.push_back(_allEmbeddings[j * 2 * _outEmbedding.getNumPoints() + 2 * i]);
-                dataTransposed.push_back(_allEmbeddings[j * 2 * _outEmbedding.getNumPoints() + 2 * i + 1]);
+            PhaseProfiler::ScopedPhase phase(&_profiler, FinalizeTrajectoryPhase);
+
+            const CancellationToken* finalizationCancellation = stoppedBeforeFinalization ? nullptr : &_cancellation;
+
+            // Aligned snapshots keep their shape, otherwise x and y are stretched to [-1, 1] separately (for 1D embeddings x is the iteration)
+            _trajectory.normalize(alignSnapshots);
+
+            // With trajectory windows the consumers extract the iterations they inspect, the output keeps the last embedding
+            if (_tsneParameters.getTrajectoryWindow() == 0)
+            {
+                // embeddings are not organized as [x(i0,t0), y(x0,t0), x(i1,t0), y(i1,t0), ...] but as [x(i0,t0), y(i0,t0), x(i0, t1), y(i0,t1), ...]
+                std::vector<float> dataTransposed = _trajectory.toPointMajor(0, _trajectory.getNumTimesteps(), finalizationCancellation);
+
+                if (stoppedBeforeFinalization || !_cancellation.isCancelled())
+                    updateEmbedding(dataTransposed, _outEmbedding.getNumPoints(), _trajectory.getNumTimesteps() * _trajectory.getNumDimensions());
             }
         }
-        //qDebug() << "transpose preparation done, length: " << dataTransposed.size();
-
-        // for x and y components of dataTransposed separately, normalize the data to [0, 1]
-        // find the min and max of x and y components
-        float xMin = dataTransposed[0];
-        float xMax = dataTransposed[0];
-        float yMin = dataTransposed[1];
-        float yMax = dataTransposed[1];
-        for (int i = 0; i < dataTransposed.size(); i += 2)
-        {
-            if (dataTransposed[i] < xMin)
-                xMin = dataTransposed[i];
-            if (dataTransposed[i] > xMax)
-                xMax = dataTransposed[i];
-            if (dataTransposed[i + 1] < yMin)
-                yMin = dataTransposed[i + 1];
-            if (dataTransposed[i + 1] > yMax)
-                yMax = dataTransposed[i + 1];
-        }
-        // normalize the data
-        for (int i = 0; i < dataTransposed.size(); i += 2)
+
+        if (computeStatistics)
         {
-            dataTransposed[i]     = (dataTransposed[i]     - xMin) / (xMax - xMin) * 2 - 1;
-            dataTransposed[i + 1] = (dataTransposed[i + 1] - yMin) / (yMax - yMin) * 2 - 1;
+            qDebug() << "tSNE: Publishing trajectory statistics over " << _trajectoryStatistics.getNumSteps() << " iterations.";
+            emit statisticsUpdate(_trajectoryStatistics.getStatistics(), _numPoints, TrajectoryStatistics::NumStatistics);
         }
 
-        updateEmbedding(dataTransposed, _outEmbedding.getNumPoints(), _allEmbeddings.size() / _outEmbedding.getNumPoints());
-
-        //updateEmbedding(_allEmbeddings, _outEmbedding.getNumPoints(), _allEmbeddings.size() / _outEmbedding.getNumPoints());
-
         _tasks->getComputeGradientDescentTask().setFinished();
     }
 
+    const auto profile = QString::fromStdString(_profiler.getSummaryTable());
+
+    // Shown with the task, the trace of the recent phases can be exported from the settings
+    _tasks->getComputeGradientDescentTask().setDescription(profile);
+
+    qDebug().noquote() << "tSNE: Phase timings\n" << profile;
     qDebug() << "--------------------------------------------------------------------------------";
     qDebug() << "tSNE: Finished embedding in: " << elapsed / 1000 << " seconds, with " << _currentIteration << " total iterations (" << endIteration - beginIteration << " new iterations)";
     qDebug() << "================================================================================";
@@ -459,6 +754,19 @@ void TsneWorker::computeGradientDescent(uint32_t iterations)
     emit finished();
 }
 
+const TrajectoryPyramid& TsneWorker::getTrajectoryPyramid() const
+{
+    // Built on first use, not at the end of every recorded computation
+    if (_trajectoryPyramid.empty() && !_trajectory.empty())
+    {
+        _trajectoryPyramid.build(_trajectory);
+
+        qDebug() << "tSNE: Trajectory pyramid with " << _trajectoryPyramid.getNumPointLevels() << " point levels and " << _trajectoryPyramid.getNumTimeLevels() << " temporal levels";
+    }
+
+    return _trajectoryPyramid;
+}
+
 void TsneWorker::copyEmbeddingOutput()
 {
     _outEmbedding.assign(_numPoints, _tsneParameters.getNumDimensionsOutput(), _embedding.getContainer());
@@ -468,14 +776,23 @@ void TsneWorker::compute()
 {
     createTasks();
 
-    connect(_parentTask, &Task::requestAbort, this, [this]() -> void { _shouldStop = true; }, Qt::DirectConnection);
+    connect(_parentTask, &Task::requestAbort, this, [this]() -> void { _cancellation.cancel(); }, Qt::DirectConnection);
 
-    _shouldStop = false;
+    _profiler.reset();
 
     double t = 0.0;
     {
         hdi::utils::ScopedTimer<double> timer(t);
 
+        // The similarities are computed in a helper thread, meanwhile this thread sets up the offscreen buffer (its context belongs to this thread) and the initial embedding
+        std::future<void> similarities;
+
+        if (!_hasProbabilityDistribution)
+            similarities = std::async(std::launch::async, [this]() -> void {
+                EmbeddingScheduler::instance().applyThreadShare();
+                computeSimilarities();
+            });
+
         _tasks->getInitializeOffScreenBufferTask().setRunning();
 
         // Create a context local to this thread that shares with the global share context
@@ -483,15 +800,26 @@ void TsneWorker::compute()
         
         _tasks->getInitializeOffScreenBufferTask().setFinished();
 
-        if (!_hasProbabilityDistribution)
-            computeSimilarities();
+        // The input data is only available before the similarities are computed
+        if (!_hasProbabilityDistribution && _tsneParameters.getPcaInitialization())
+            computePcaInitEmbedding();
+
+        if (similarities.valid())
+        {
+            similarities.get();
 
-        computeGradientDescent(_tsneParameters.getNumIterations());
+            // The gradient descent only needs the similarities, free a gathered copy of the data (or stop reading a borrowed buffer) right away
+            _input.release();
+        }
+
+        // Stopped similarities were released, the gradient descent is not initialized with them
+        if (!_cancellation.isCancelled())
+            computeGradientDescent(_tsneParameters.getNumIterations());
     }
  
     qDebug() << "t-SNE total compute time: " << t / 1000 << " seconds.";
 
-    if (_shouldStop)
+    if (_cancellation.isCancelled())
         _tasks->getComputeGradientDescentTask().setAborted();
     else
         _tasks->getComputeGradientDescentTask().setFinished();
@@ -501,15 +829,40 @@ void TsneWorker::compute()
     resetThread();
 }
 
+void TsneWorker::computeSharedProbabilityDistribution()
+{
+    createTasks();
+
+    if (!_hasProbabilityDistribution)
+    {
+        if (_tsneParameters.getPcaInitialization())
+            computePcaInitEmbedding();
+
+        computeSimilarities();
+        _input.release();
+
+        if (_cancellation.isCancelled())
+        {
+            resetThread();
+            return;
+        }
+
+        // The similarities are already symmetrized
+        _sharedProbabilityDistribution = std::make_shared<const ProbDistMatrix>(std::move(_probabilityDistribution));
+        _probabilityDistribution = ProbDistMatrix();
+        _hasProbabilityDistribution = true;
+    }
+
+    resetThread();
+}
+
 void TsneWorker::continueComputation(uint32_t iterations)
 {
     _tasks->getInitializeOffScreenBufferTask().setEnabled(false);
     _tasks->getComputingSimilaritiesTask().setEnabled(false);
     _tasks->getInitializeTsneTask().setEnabled(false);
     
-    connect(_parentTask, &Task::requestAbort, this, [this]() -> void { _shouldStop = true; }, Qt::DirectConnection);
-
-    _shouldStop = false;
+    connect(_parentTask, &Task::requestAbort, this, [this]() -> void { _cancellation.cancel(); }, Qt::DirectConnection);
 
     computeGradientDescent(iterations);
 
@@ -520,32 +873,56 @@ void TsneWorker::continueComputation(uint32_t iterations)
 
 void TsneWorker::stop()
 {
-    _shouldStop = true;
+    _cancellation.cancel();
+}
+
+std::shared_ptr<const ProbDistMatrix> TsneWorker::shareProbabilityDistribution()
+{
+    // The gradient descent keeps its own copy, afterwards the distribution is only read for restarts and serialization
+    if (!_sharedProbabilityDistribution && !_probabilityDistribution.empty())
+    {
+        _sharedProbabilityDistribution = std::make_shared<const ProbDistMatrix>(std::move(_probabilityDistribution));
+        _probabilityDistribution = ProbDistMatrix();
+    }
+
+    return _sharedProbabilityDistribution;
 }
 
 TsneAnalysis::TsneAnalysis() :
     _tsneWorker(nullptr),
-    _task(nullptr)
+    _task(nullptr),
+    _jobId(0),
+    _priority(0)
 {
     qRegisterMetaType<TsneData>();
 }
 
 TsneAnalysis::~TsneAnalysis()
 {
-    _workerThread.quit();           // Signal the thread to quit gracefully
-    if (!_workerThread.wait(500))   // Wait for the thread to actually finish
-        _workerThread.terminate();  // Terminate thread after 0.5 seconds
-
     deleteWorker();
 }
 
 void TsneAnalysis::deleteWorker()
 {
-    if (_tsneWorker)
+    if (!_tsneWorker)
+        return;
+
+    // Reset first, such that a cancelled job does not report an abort of the next computation
+    TsneWorker* tsneWorker = _tsneWorker;
+    _tsneWorker = nullptr;
+
+    auto& scheduler = EmbeddingScheduler::instance();
+
+    if (!scheduler.cancel(_jobId) && scheduler.isRunning(_jobId))
     {
-        _tsneWorker->changeThread(QThread::currentThread());
-        delete _tsneWorker;
+        tsneWorker->stop();
+        scheduler.wait(_jobId);
     }
+
+    _jobId = 0;
+
+    tsneWorker->changeThread(QThread::currentThread());
+    delete tsneWorker;
 }
 
 void TsneAnalysis::startComputation(TsneParameters parameters, const std::vector<hdi::data::MapMemEff<uint32_t, float>>& probDist, uint32_t numPoints, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding, int previousIterations)
@@ -572,6 +949,18 @@ void TsneAnalysis::startComputation(TsneParameters parameters, std::vector<hdi::
     startComputation(_tsneWorker);
 }
 
+void TsneAnalysis::startComputation(TsneParameters parameters, std::shared_ptr<const ProbDistMatrix> jointProbDist, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding, int previousIterations)
+{
+    deleteWorker();
+
+    _tsneWorker = new TsneWorker(parameters, std::move(jointProbDist), initEmbedding);
+
+    if (previousIterations >= 0)
+        _tsneWorker->setCurrentIteration(previousIterations);
+
+    startComputation(_tsneWorker);
+}
+
 void TsneAnalysis::startComputation(TsneParameters parameters, KnnParameters knnParameters, const std::vector<float>& data, uint32_t numDimensions, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding)
 {
     deleteWorker();
@@ -590,19 +979,48 @@ void TsneAnalysis::startComputation(TsneParameters parameters, KnnParameters knn
     startComputation(_tsneWorker);
 }
 
+void TsneAnalysis::startComputation(TsneParameters parameters, KnnParameters knnParameters, TsneInputData&& input, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding)
+{
+    deleteWorker();
+
+    _tsneWorker = new TsneWorker(parameters, knnParameters, std::move(input), initEmbedding);
+    
+    startComputation(_tsneWorker);
+}
+
 void TsneAnalysis::continueComputation(int iterations)
 {
     if (!canContinue())
         return;
 
-    _tsneWorker->changeThread(&_workerThread);
+    TsneWorker* tsneWorker = _tsneWorker;
+
+    submitJob([tsneWorker, iterations]() -> void {
+        tsneWorker->continueComputation(iterations);
+    });
+}
+
+std::shared_ptr<const ProbDistMatrix> TsneAnalysis::shareProbabilityDistribution()
+{
+    if (!_tsneWorker)
+        return nullptr;
+
+    auto& scheduler = EmbeddingScheduler::instance();
+
+    // The worker might still compute or read its distribution
+    if (scheduler.isQueued(_jobId) || scheduler.isRunning(_jobId))
+        return _tsneWorker->getSharedProbabilityDistribution();
 
-    emit continueWorker(iterations);
+    return _tsneWorker->shareProbabilityDistribution();
 }
 
 void TsneAnalysis::stopComputation()
 {
-    emit stopWorker();  // to _workerThread in Thread
+    // A computation that is still queued never starts, the cancellation reports the abort
+    if (EmbeddingScheduler::instance().cancel(_jobId))
+        return;
+
+    emit stopWorker();  // to the worker in its pool thread
     
     emit aborted();     // to external listeners
 }
@@ -623,23 +1041,53 @@ void TsneAnalysis::startComputation(TsneWorker* tsneWorker)
 {
     tsneWorker->setParentTask(_task);
 
-    tsneWorker->changeThread(&_workerThread);
-    
     // To-Worker signals
-    connect(this, &TsneAnalysis::startWorker, tsneWorker, &TsneWorker::compute);
-    connect(this, &TsneAnalysis::continueWorker, tsneWorker, &TsneWorker::continueComputation);
     connect(this, &TsneAnalysis::stopWorker, tsneWorker, &TsneWorker::stop, Qt::DirectConnection);
 
     // From-Worker signals
     connect(tsneWorker, &TsneWorker::embeddingUpdate, this, &TsneAnalysis::embeddingUpdate);
+    connect(tsneWorker, &TsneWorker::statisticsUpdate, this, &TsneAnalysis::statisticsUpdate);
+    connect(tsneWorker, &TsneWorker::trajectoryBudgetUpdate, this, &TsneAnalysis::trajectoryBudgetUpdate);
     connect(tsneWorker, &TsneWorker::finished, this, &TsneAnalysis::finished);
 
-    _workerThread.start();
+    submitJob([tsneWorker]() -> void {
+        tsneWorker->compute();
+    });
 
-    emit startWorker();
     emit started();
 }
 
+void TsneAnalysis::submitJob(std::function<void()> run)
+{
+    TsneWorker* tsneWorker = _tsneWorker;
+
+    EmbeddingJob job;
+    job.context = this;
+    job.priority = _priority;
+    job.task = _task;
+    job.run = std::move(run);
+
+    // Cleared here and not when the job starts, a stop requested while the job is queued must not be lost
+    tsneWorker->resetCancellation();
+
+    // The worker (and its offscreen buffer) lives in the pool thread while the job runs and moves back afterwards
+    job.prepare = [tsneWorker](QThread* poolThread) -> void {
+        tsneWorker->changeThread(poolThread);
+    };
+
+    job.cancelled = [this, tsneWorker]() -> void {
+        if (tsneWorker != _tsneWorker)
+            return;
+
+        if (_task)
+            _task->setAborted();
+
+        emit aborted();
+    };
+
+    _jobId = EmbeddingScheduler::instance().submit(std::move(job));
+}
+
 TsneWorkerTasks::TsneWorkerTasks(QObject* parent, mv::Task* parentTask) :
     QObject(parent),
     _initializeOffScreenBufferTask(this, "Initialize off-screen GPGPU buffer", Task::GuiScopes{ Task::GuiScope::DataHierarchy, Task::GuiScope::Foreground }, Task::Status::Idle),
@@ -653,7 +1101,6 @@ TsneWorkerTasks::TsneWorkerTasks(QObject* parent, mv::Task* parentTask) :
     _computeGradientDescentTask.setParentTask(parentTask);
 
     _computeGradientDescentTask.setWeight(20.f);
-    _computeGradientDescentTask.setSubtaskNamePrefix("Compute gradient descent step");
 
     /*
     _initializeOffScreenBufferTask.moveToThread(targetThread);
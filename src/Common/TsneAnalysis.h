@@ -1,7 +1,15 @@
 #pragma once
 
+#include "CancellationToken.h"
+#include "EmbeddingScheduler.h"
 #include "KnnParameters.h"
+#include "PhaseProfiler.h"
+#include "ProcrustesAlignment.h"
+#include "Trajectory.h"
+#include "TrajectoryPyramid.h"
+#include "TrajectoryStatistics.h"
 #include "TsneData.h"
+#include "TsneInputData.h"
 #include "TsneParameters.h"
 
 #include "hdi/dimensionality_reduction/gradient_descent_tsne_texture.h"
@@ -13,6 +21,8 @@
 
 #include <QThread>
 
+#include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -53,10 +63,14 @@ public:
     TsneWorker(TsneParameters tsneParameters, KnnParameters knnParameters, const std::vector<float>& data, uint32_t numDimensions, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding);
     // The tsne object will compute knn and a probablility distribution before starting the embedding, moving the input data
     TsneWorker(TsneParameters tsneParameters, KnnParameters knnParameters, std::vector<float>&& data, uint32_t numDimensions, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding);
+    // The tsne object will compute knn and a probablility distribution before starting the embedding, the input may borrow the data
+    TsneWorker(TsneParameters tsneParameters, KnnParameters knnParameters, TsneInputData&& input, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding);
     // The tsne object expects a probDist that is not symmetrized, no knn are computed
     TsneWorker(TsneParameters tsneParameters, const std::vector<hdi::data::MapMemEff<uint32_t, float>>& probDist, uint32_t numPoints, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding);
     // The tsne object expects a probDist that is not symmetrized, no knn are computed, moving the probDist
     TsneWorker(TsneParameters tsneParameters, std::vector<hdi::data::MapMemEff<uint32_t, float>>&& probDist, uint32_t numPoints, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding);
+    // The tsne object shares a joint (symmetrized) probDist with other workers, no knn are computed
+    TsneWorker(TsneParameters tsneParameters, std::shared_ptr<const ProbDistMatrix> jointProbDist, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding);
     ~TsneWorker();
 
     void createTasks();
@@ -66,24 +80,46 @@ public: // Setter
     void setInitEmbedding(const hdi::data::Embedding<float>::scalar_vector_type& initEmbedding);
     void setCurrentIteration(int currentIteration);
     void changeThread(QThread* targetThread);
+    /** Clear the stop request of a previous job, on the submitting thread before the next job of this worker is queued */
+    void resetCancellation() { _cancellation.reset(); }
 
 public: // Getter
     ProbDistMatrix* getProbabilityDistribution() { return &_probabilityDistribution; };
+    std::shared_ptr<const ProbDistMatrix> getSharedProbabilityDistribution() const { return _sharedProbabilityDistribution; };
+    /** Move the probability distribution into shared, read-only ownership without copying it. Only while no job of this worker runs */
+    std::shared_ptr<const ProbDistMatrix> shareProbabilityDistribution();
+    const hdi::data::Embedding<float>::scalar_vector_type& getEmbedding() const { return _embedding.getContainer(); };
+    bool hasInitEmbedding() const { return _tsneParameters.getPresetEmbedding(); };
+    /** Recorded embeddings, only valid while no gradient descent is running */
+    const Trajectory& getTrajectory() const { return _trajectory; };
+    /** Level-of-detail index over the recorded embeddings, built on first use after the gradient descent; only while no gradient descent is running */
+    const TrajectoryPyramid& getTrajectoryPyramid() const;
+    /** Timings of the phases of the computation, e.g. the steps of every gradient descent iteration */
+    const PhaseProfiler& getProfiler() const { return _profiler; };
     int getNumIterations() const;
+    /** Whether the gradient descent was initialized with complete similarities, a computation stopped while computing them cannot be continued */
+    bool canContinue();
 
 public slots:
     void compute();
+    /** Compute the similarities (and a PCA initialization) only, afterwards the joint probability distribution can be shared with other workers */
+    void computeSharedProbabilityDistribution();
     void continueComputation(uint32_t iterations);
     void stop();
 
 signals:
     //void embeddingUpdate(TsneData tsneData);
     void embeddingUpdate(const std::vector<float> embeddingRecords, const int numPoints, const int numDismensions);
+    /** Per-point trajectory statistics, point-major with numStatistics values per point, see TrajectoryStatistics */
+    void statisticsUpdate(const std::vector<float> statistics, const int numPoints, const int numStatistics);
+    /** Memory estimate of the trajectory recording and the adaptation applied to fit the memory budget, see TrajectoryBudget */
+    void trajectoryBudgetUpdate(const QString description);
     void finished();
     void aborted();
 
 private:
     void computeSimilarities();
+    void computePcaInitEmbedding();
     void computeGradientDescent(uint32_t iterations);
     
     void copyEmbeddingOutput();
@@ -99,16 +135,21 @@ private:
     int                                     _currentIteration;              /** Current iteration in the embedding / gradient descent process */
     uint32_t                                _numPoints;                     /** Data variable */
     uint32_t                                _numDimensions;                 /** Data variable */
-    std::vector<float>                      _data;                          /** High-dimensional input data */
+    TsneInputData                           _input;                         /** High-dimensional input data, released once the similarities are computed */
     ProbDistMatrix                          _probabilityDistribution;       /** High-dimensional probability distribution encoding point similarities */
+    std::shared_ptr<const ProbDistMatrix>   _sharedProbabilityDistribution; /** Joint probability distribution shared with other workers, used instead of _probabilityDistribution if set */
     bool                                    _hasProbabilityDistribution;    /** Check if the worker was initialized with a probability distribution or data */
     GradientDescentGPU                       _GPGPU_tSNE;                   /** GPGPU t-SNE gradient descent implementation */
     GradientDescentCPU                       _CPU_tSNE;                     /** CPU t-SNE gradient descent implementation */
     hdi::data::Embedding<float>             _embedding;                     /** Storage of current embedding */
     TsneData                                _outEmbedding;                  /** Transfer embedding data array */
     OffscreenBuffer*                        _offscreenBuffer;               /** Offscreen OpenGL buffer required to run the gradient descent */
-    bool                                    _shouldStop;                    /** Termination flags */
-    std::vector<float>                      _allEmbeddings;                 /** All embeddings over the iterations */
+    CancellationToken                       _cancellation;                  /** Stop request, cancelled from the GUI thread and polled by the computation */
+    Trajectory                              _trajectory;                    /** All (subsampled) embeddings over the iterations, 1D embeddings are recorded with the iteration as first coordinate */
+    mutable TrajectoryPyramid               _trajectoryPyramid;             /** Levels of detail of _trajectory, built on request */
+    TrajectoryStatistics                    _trajectoryStatistics;          /** Per-point statistics of the embeddings over all iterations */
+    ProcrustesAlignment                     _alignment;                     /** Removes the rigid motion between recorded 2D snapshots */
+    PhaseProfiler                           _profiler;                      /** Timings of the phases of the computation */
     //std::vector<float>                      _embedding1D;                   /** 1D embedding */
     //std::vector<float> _outputdata;                                         /** Output data */
 
@@ -130,10 +171,14 @@ public: // Interactions
     void startComputation(TsneParameters parameters, const std::vector<hdi::data::MapMemEff<uint32_t, float>>& probDist, uint32_t numPoints, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding = nullptr, int iterations = -1);
     // Compute embedding based on pre-computed similarites, moves the input probDist
     void startComputation(TsneParameters parameters, std::vector<hdi::data::MapMemEff<uint32_t, float>>&& probDist, uint32_t numPoints, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding = nullptr, int iterations = -1);
+    // Compute embedding based on pre-computed joint similarites that are shared with other computations
+    void startComputation(TsneParameters parameters, std::shared_ptr<const ProbDistMatrix> jointProbDist, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding = nullptr, int iterations = -1);
     // Compute similarities (aknn search) and embedding
     void startComputation(TsneParameters parameters, KnnParameters knnParameters, const std::vector<float>& data, uint32_t numDimensions, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding = nullptr);
     // Compute similarities (aknn search) and embedding, moves the input data
     void startComputation(TsneParameters parameters, KnnParameters knnParameters, std::vector<float>&& data, uint32_t numDimensions, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding = nullptr);
+    // Compute similarities (aknn search) and embedding, the input may borrow the data of a data set
+    void startComputation(TsneParameters parameters, KnnParameters knnParameters, TsneInputData&& input, const hdi::data::Embedding<float>::scalar_vector_type* initEmbedding = nullptr);
     
     void continueComputation(int previousIterations);
     void stopComputation();
@@ -141,32 +186,46 @@ public: // Interactions
 public: // Setter
     void setTask(mv::Task* task);
     void setInitEmbedding(const hdi::data::Embedding<float>::scalar_vector_type& initEmbedding);
+    /** Scheduling priority of subsequent computations, higher priorities are started first when all embedding workers are busy */
+    void setPriority(int priority) { _priority = priority; };
 
 public: // Getter
     int getNumIterations() const { return (_tsneWorker) ? _tsneWorker->getNumIterations() : -1; };
-    bool canContinue() const { return (_tsneWorker) ? _tsneWorker->getNumIterations() >= 1 : false; };
+    bool canContinue() const { return (_tsneWorker) ? _tsneWorker->getNumIterations() >= 1 && _tsneWorker->canContinue() : false; };
     std::optional<ProbDistMatrix*> getProbabilityDistribution() { return (_tsneWorker) ? std::optional<ProbDistMatrix*>(_tsneWorker->getProbabilityDistribution()) : std::nullopt; };
     const std::optional<ProbDistMatrix*> getProbabilityDistribution() const { return (_tsneWorker) ? std::optional<ProbDistMatrix*>(_tsneWorker->getProbabilityDistribution()) : std::nullopt; };
+    /** Joint probability distribution of the last computation if it is shared, getProbabilityDistribution() is empty then */
+    std::shared_ptr<const ProbDistMatrix> getSharedProbabilityDistribution() const { return (_tsneWorker) ? _tsneWorker->getSharedProbabilityDistribution() : nullptr; };
+    /** Share the probability distribution of the last computation without copying it, nullptr while it is being computed */
+    std::shared_ptr<const ProbDistMatrix> shareProbabilityDistribution();
+    /** Recorded embeddings of the last computation, time slices and per-point trajectories; only valid while no computation is running */
+    const Trajectory* getTrajectory() const { return (_tsneWorker) ? &_tsneWorker->getTrajectory() : nullptr; };
+    /** Levels of detail of the recorded embeddings, extract them from getTrajectory(); only valid while no computation is running */
+    const TrajectoryPyramid* getTrajectoryPyramid() const { return (_tsneWorker) ? &_tsneWorker->getTrajectoryPyramid() : nullptr; };
+    /** Phase timings of the last computation, export them while no computation is running */
+    const PhaseProfiler* getProfiler() const { return (_tsneWorker) ? &_tsneWorker->getProfiler() : nullptr; };
 
 private: // Internal
     void startComputation(TsneWorker* tsneWorker);
+    void submitJob(std::function<void()> run);
     void deleteWorker();
 
 signals:
     // Local signals
-    void startWorker();
-    void continueWorker(uint32_t iterations);
     void stopWorker();
 
     // Outgoing signals
     //void embeddingUpdate(const TsneData tsneData);
     void embeddingUpdate(const std::vector<float> embeddingRecords, const int numPoints, const int numDismensions);
+    void statisticsUpdate(const std::vector<float> statistics, const int numPoints, const int numStatistics);
+    void trajectoryBudgetUpdate(const QString description);
     void started();
     void finished();
     void aborted();
 
 private:
-    QThread         _workerThread;
-    TsneWorker*     _tsneWorker;
-    mv::Task*       _task;
+    TsneWorker*                 _tsneWorker;
+    mv::Task*                   _task;
+    EmbeddingScheduler::JobId   _jobId;         /** Scheduler job of the current computation */
+    int                         _priority;      /** Scheduling priority of the computations */
 };
@@ -0,0 +1,110 @@
+#include "TsneInputData.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+    /**
+     * Locks a data set while its buffer is borrowed, a locked data set cannot be removed and its data not be replaced.
+     * The pin may be released in a worker thread, the data set is unlocked in the application thread
+     */
+    class DatasetLock
+    {
+    public:
+        explicit DatasetLock(const mv::Dataset<Points>& points) :
+            _points(std::make_unique<mv::Dataset<Points>>(points))
+        {
+            (*_points)->lock();
+        }
+
+        ~DatasetLock()
+        {
+            auto points = _points.release();
+
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [points]() -> void {
+                if (points->isValid())
+                    (*points)->unlock();
+
+                delete points;
+            }, Qt::QueuedConnection);
+        }
+
+        DatasetLock(const DatasetLock&) = delete;
+        DatasetLock& operator=(const DatasetLock&) = delete;
+
+    private:
+        std::unique_ptr<mv::Dataset<Points>>    _points;    /** Locked data set */
+    };
+}
+
+TsneInputData::TsneInputData(std::vector<float>&& data, uint32_t numDimensions) :
+    _owned(std::move(data)),
+    _view(nullptr),
+    _numPoints(0),
+    _numDimensions(numDimensions),
+    _pin()
+{
+    assert(numDimensions > 0);
+    _numPoints = static_cast<uint32_t>(_owned.size() / numDimensions);
+    _view = _owned.empty() ? nullptr : _owned.data();
+}
+
+TsneInputData::TsneInputData(const float* data, uint32_t numPoints, uint32_t numDimensions, std::shared_ptr<const void> pin) :
+    _owned(),
+    _view(data),
+    _numPoints(numPoints),
+    _numDimensions(numDimensions),
+    _pin(std::move(pin))
+{
+}
+
+TsneInputData TsneInputData::fromPoints(const mv::Dataset<Points>& points, const std::vector<bool>& enabledDimensions)
+{
+    std::vector<unsigned int> dimensionIndices;
+    for (unsigned int i = 0; i < points->getNumDimensions(); i++)
+        if (enabledDimensions[i])
+            dimensionIndices.push_back(i);
+
+    const auto numDimensions = static_cast<uint32_t>(dimensionIndices.size());
+    const auto numPoints = static_cast<uint32_t>(points->isFull() ? points->getNumPoints() : points->indices.size());
+
+    // A full float data set with all dimensions enabled already has the point-major layout of the workers.
+    // The lock keeps the buffer valid, a data set locked by someone else might be unlocked while the buffer is used
+    if (points->isFull() && numDimensions == points->getNumDimensions() && !points->isLocked())
+    {
+        const float* buffer = nullptr;
+
+        points->constVisitFromBeginToEnd([&buffer](auto begin, auto end) {
+            using ValueType = std::decay_t<decltype(*begin)>;
+
+            if constexpr (std::is_same_v<ValueType, float>)
+                if (begin != end)
+                    buffer = &(*begin);
+        });
+
+        if (buffer)
+        {
+            qDebug() << "TsneInputData: using the data of " << points->getGuiName() << " without copying";
+            return TsneInputData(buffer, numPoints, numDimensions, std::make_shared<const DatasetLock>(points));
+        }
+    }
+
+    std::vector<float> data(static_cast<size_t>(numPoints) * numDimensions);
+    points->populateDataForDimensions<std::vector<float>, std::vector<unsigned int>>(data, dimensionIndices);
+
+    return TsneInputData(std::move(data), numDimensions);
+}
+
+void TsneInputData::release()
+{
+    _owned.clear();
+    _owned.shrink_to_fit();
+    _view = nullptr;
+    _pin.reset();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "PointData/PointData.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * TsneInputData
+ *
+ * High-dimensional input of a similarity computation, point-major with numDimensions values per point.
+ * Either owns a gathered copy of the data or borrows the buffer of a data set. A borrowed view is
+ * read-only and holds a pin that keeps the buffer valid until the input is released, for data sets
+ * the pin locks the data set such that it cannot be removed or changed meanwhile.
+ */
+class TsneInputData
+{
+public:
+    TsneInputData() = default;
+    TsneInputData(TsneInputData&&) = default;
+    TsneInputData& operator=(TsneInputData&&) = default;
+
+    // The view of owned data points into the own buffer, copies would share it
+    TsneInputData(const TsneInputData&) = delete;
+    TsneInputData& operator=(const TsneInputData&) = delete;
+
+    /** Own the data, e.g. a gathered copy of a subset or of a dimension selection */
+    TsneInputData(std::vector<float>&& data, uint32_t numDimensions);
+
+    /** Borrow a buffer of numPoints * numDimensions values, pin keeps the buffer alive */
+    TsneInputData(const float* data, uint32_t numPoints, uint32_t numDimensions, std::shared_ptr<const void> pin);
+
+    /**
+     * Input for the enabled dimensions of a points data set. The buffer of a full float data set
+     * with all dimensions enabled is borrowed and the data set is locked until the input is released,
+     * otherwise (or if the data set is already locked) the enabled dimensions are gathered into a copy
+     * @param points Input data set
+     * @param enabledDimensions For every dimension of the data set whether it is used
+     */
+    static TsneInputData fromPoints(const mv::Dataset<Points>& points, const std::vector<bool>& enabledDimensions);
+
+    const float* data() const { return _view; }
+    uint32_t getNumPoints() const { return _numPoints; }
+    uint32_t getNumDimensions() const { return _numDimensions; }
+    size_t size() const { return static_cast<size_t>(_numPoints) * _numDimensions; }
+
+    bool empty() const { return _view == nullptr; }
+    bool isBorrowed() const { return _view != nullptr && _owned.empty(); }
+
+    /** Free owned data, drop the view and release the pin, e.g. once the similarities are computed */
+    void release();
+
+private:
+    std::vector<float>          _owned;             /** Owned data, empty for borrowed input */
+    const float*                _view = nullptr;    /** Owned data or borrowed buffer */
+    uint32_t                    _numPoints = 0;     /** Number of points */
+    uint32_t                    _numDimensions = 0; /** Number of values per point */
+    std::shared_ptr<const void> _pin;               /** Keeps a borrowed buffer valid while it exists */
+};
@@ -17,10 +17,16 @@ public:
         _exponentialDecayIter(150),
         _numDimensionsOutput(2),
         _presetEmbedding(false),
+        _pcaInitialization(false),
         _exaggerationFactor(4),
         _updateCore(10),
         _gradientDescentType(GradientDescentType::CPU),
-        _subsampleFactor(10)
+        _subsampleFactor(10),
+        _recordTrajectory(true),
+        _trajectoryStatistics(false),
+        _alignSnapshots(false),
+        _trajectoryWindow(0),
+        _trajectoryMemoryBudget(4096)
     {
 
     }
@@ -31,10 +37,16 @@ public:
     void setExponentialDecayIter(int exponentialDecayIter) { _exponentialDecayIter = exponentialDecayIter; }
     void setNumDimensionsOutput(int numDimensionsOutput) { _numDimensionsOutput = numDimensionsOutput; }
     void setPresetEmbedding(bool presetEmbedding) { _presetEmbedding = presetEmbedding; }
+    void setPcaInitialization(bool pcaInitialization) { _pcaInitialization = pcaInitialization; }
     void setExaggerationFactor(double exaggerationFactor) { _exaggerationFactor = exaggerationFactor; }
     void setGradientDescentType(GradientDescentType gradientDescentType) { _gradientDescentType = gradientDescentType; }
     void setUpdateCore(int updateCore) { _updateCore = updateCore; }
     void setSubsampleFactor(int subsampleFactor) { _subsampleFactor = subsampleFactor; }
+    void setRecordTrajectory(bool recordTrajectory) { _recordTrajectory = recordTrajectory; }
+    void setTrajectoryStatistics(bool trajectoryStatistics) { _trajectoryStatistics = trajectoryStatistics; }
+    void setAlignSnapshots(bool alignSnapshots) { _alignSnapshots = alignSnapshots; }
+    void setTrajectoryWindow(int trajectoryWindow) { _trajectoryWindow = trajectoryWindow; }
+    void setTrajectoryMemoryBudget(int trajectoryMemoryBudget) { _trajectoryMemoryBudget = trajectoryMemoryBudget; }
 
     int getNumIterations() const { return _numIterations; }
     int getPerplexity() const { return _perplexity; }
@@ -42,10 +54,16 @@ public:
     int getExponentialDecayIter() const { return _exponentialDecayIter; }
     int getNumDimensionsOutput() const { return _numDimensionsOutput; }
     int getPresetEmbedding() const { return _presetEmbedding; }
-    int getExaggerationFactor() const { return _exaggerationFactor; }
+    bool getPcaInitialization() const { return _pcaInitialization; }
+    double getExaggerationFactor() const { return _exaggerationFactor; }
     GradientDescentType getGradientDescentType() const { return _gradientDescentType; }
     int getUpdateCore() const { return _updateCore; }
     int getSubsampleFactor() const { return _subsampleFactor; }
+    bool getRecordTrajectory() const { return _recordTrajectory; }
+    bool getTrajectoryStatistics() const { return _trajectoryStatistics; }
+    bool getAlignSnapshots() const { return _alignSnapshots; }
+    int getTrajectoryWindow() const { return _trajectoryWindow; }
+    int getTrajectoryMemoryBudget() const { return _trajectoryMemoryBudget; }
 
 private:
     int _numIterations;
@@ -55,7 +73,13 @@ private:
     int _numDimensionsOutput;
     double _exaggerationFactor;
     bool _presetEmbedding;
+    bool _pcaInitialization;    // Whether the worker initializes the embedding with the principal components of the input data
     int _subsampleFactor;
+    bool _recordTrajectory;     // Whether the (subsampled) embeddings of all iterations are kept and published at the end
+    bool _trajectoryStatistics; // Whether per-point statistics of the embeddings over the iterations are accumulated and published at the end
+    bool _alignSnapshots;       // Whether recorded 2D snapshots are rotated and translated onto the previous one
+    int _trajectoryWindow;      // Iterations per trajectory window data set, 0 publishes the whole trajectory in the output data set
+    int _trajectoryMemoryBudget;    // Memory ceiling of the trajectory recording in MB, 0 for no ceiling, see TrajectoryBudget
     GradientDescentType _gradientDescentType;     // Whether to use CPU or GPU gradient descent
 
     int _updateCore;        // Gradient descent iterations after which the embedding data set in ManiVault's core will be updated
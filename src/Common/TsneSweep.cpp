@@ -0,0 +1,320 @@
+#include "TsneSweep.h"
+
+#include <QDebug>
+#include <QThread>
+
+#include <cassert>
+#include <utility>
+
+using namespace mv;
+
+TsneSweep::TsneSweep() :
+    _variants(),
+    _probabilityDistribution(),
+    _task(nullptr),
+    _similarityJobId(0),
+    _numPendingVariants(0),
+    _stopped(false),
+    _priority(0)
+{
+    connect(&EmbeddingScheduler::instance(), &EmbeddingScheduler::jobFinished, this, &TsneSweep::onJobFinished);
+}
+
+TsneSweep::~TsneSweep()
+{
+    deleteWorkers();
+}
+
+void TsneSweep::setTask(mv::Task* task)
+{
+    assert(task);
+    _task = task;
+
+    connect(_task, &Task::requestAbort, this, [this]() -> void { stopComputation(); });
+}
+
+void TsneSweep::startComputation(const std::vector<TsneParameters>& variants, KnnParameters knnParameters, TsneInputData&& input, std::vector<std::vector<float>> initEmbeddings)
+{
+    deleteWorkers();
+
+    _stopped = false;
+
+    if (variants.empty() || input.empty())
+    {
+        qWarning() << "TsneSweep::startComputation: no variants or no input data";
+        return;
+    }
+
+    createVariants(variants, std::move(initEmbeddings));
+
+    // The first variant computes the similarities, its gradient descent starts together with the others afterwards
+    auto& first = _variants.front();
+
+    first.worker = new TsneWorker(first.parameters, knnParameters, std::move(input), first.initEmbedding.empty() ? nullptr : &first.initEmbedding);
+    first.worker->setParentTask(first.task.get());
+
+    TsneWorker* tsneWorker = first.worker;
+
+    EmbeddingJob job;
+    job.context = this;
+    job.priority = _priority;
+
+    job.prepare = [tsneWorker](QThread* poolThread) -> void {
+        tsneWorker->changeThread(poolThread);
+    };
+
+    job.run = [tsneWorker]() -> void {
+        tsneWorker->computeSharedProbabilityDistribution();
+    };
+
+    job.cancelled = [this]() -> void {
+        if (_similarityJobId == 0)
+            return;
+
+        _similarityJobId = 0;
+        finishSweep();
+    };
+
+    if (_task)
+        _task->setRunning();
+
+    _similarityJobId = EmbeddingScheduler::instance().submit(std::move(job));
+
+    qDebug() << "TsneSweep: computing similarities for " << _variants.size() << " variants";
+
+    emit started();
+}
+
+void TsneSweep::startComputation(const std::vector<TsneParameters>& variants, std::shared_ptr<const ProbDistMatrix> jointProbDist, std::vector<std::vector<float>> initEmbeddings)
+{
+    deleteWorkers();
+
+    _stopped = false;
+
+    if (variants.empty() || !jointProbDist || jointProbDist->size() == 0)
+    {
+        qWarning() << "TsneSweep::startComputation: no variants or no probability distribution";
+        return;
+    }
+
+    createVariants(variants, std::move(initEmbeddings));
+
+    _probabilityDistribution = std::move(jointProbDist);
+
+    if (_task)
+        _task->setRunning();
+
+    qDebug() << "TsneSweep: computing " << _variants.size() << " variants from a shared probability distribution";
+
+    emit started();
+
+    startGradientDescents();
+}
+
+void TsneSweep::createVariants(const std::vector<TsneParameters>& variants, std::vector<std::vector<float>> initEmbeddings)
+{
+    initEmbeddings.resize(variants.size());
+
+    _variants.resize(variants.size());
+
+    for (std::size_t variantIndex = 0; variantIndex < variants.size(); variantIndex++)
+    {
+        auto& variant = _variants[variantIndex];
+
+        variant.parameters = variants[variantIndex];
+        variant.initEmbedding = std::move(initEmbeddings[variantIndex]);
+        variant.task = std::make_unique<mv::Task>(this, QString("Variant %1").arg(variantIndex + 1));
+
+        if (_task)
+            variant.task->setParentTask(_task);
+    }
+}
+
+void TsneSweep::stopComputation()
+{
+    _stopped = true;
+
+    auto& scheduler = EmbeddingScheduler::instance();
+
+    // A running similarity computation stops at its next cancellation check, its completion ends the sweep
+    if (_similarityJobId != 0 && !scheduler.cancel(_similarityJobId) && _variants.front().worker)
+        _variants.front().worker->stop();
+
+    for (std::size_t variantIndex = 0; variantIndex < _variants.size(); variantIndex++)
+    {
+        auto& variant = _variants[variantIndex];
+
+        if (variant.jobId == 0)
+            continue;
+
+        if (!scheduler.cancel(variant.jobId) && variant.worker)
+            variant.worker->stop();
+    }
+}
+
+void TsneSweep::onSimilaritiesComputed()
+{
+    _probabilityDistribution = _variants.front().worker->getSharedProbabilityDistribution();
+
+    if (_stopped || !_probabilityDistribution)
+    {
+        finishSweep();
+        return;
+    }
+
+    startGradientDescents();
+}
+
+void TsneSweep::startGradientDescents()
+{
+    // A PCA initialization computed by the first variant is used by all variants with the same embedding dimensions
+    const TsneWorker* firstWorker = _variants.front().worker;
+    const auto& firstParameters = _variants.front().parameters;
+    const bool sharePcaInit = firstWorker && firstParameters.getPcaInitialization() && firstWorker->hasInitEmbedding();
+
+    for (auto& variant : _variants)
+    {
+        if (variant.worker)
+            continue;
+
+        const std::vector<float>* initEmbedding = variant.initEmbedding.empty() ? nullptr : &variant.initEmbedding;
+
+        if (sharePcaInit && variant.parameters.getNumDimensionsOutput() == firstParameters.getNumDimensionsOutput())
+            initEmbedding = &firstWorker->getEmbedding();
+
+        variant.worker = new TsneWorker(variant.parameters, _probabilityDistribution, initEmbedding);
+        variant.worker->setParentTask(variant.task.get());
+    }
+
+    for (std::size_t variantIndex = 0; variantIndex < _variants.size(); variantIndex++)
+        submitVariant(variantIndex);
+}
+
+void TsneSweep::onJobFinished(EmbeddingScheduler::JobId jobId)
+{
+    if (jobId == 0)
+        return;
+
+    if (jobId == _similarityJobId)
+    {
+        _similarityJobId = 0;
+        onSimilaritiesComputed();
+        return;
+    }
+
+    for (std::size_t variantIndex = 0; variantIndex < _variants.size(); variantIndex++)
+    {
+        if (_variants[variantIndex].jobId != jobId)
+            continue;
+
+        _variants[variantIndex].jobId = 0;
+        variantDone(variantIndex);
+        return;
+    }
+}
+
+void TsneSweep::submitVariant(std::size_t variantIndex)
+{
+    auto& variant = _variants[variantIndex];
+
+    TsneWorker* tsneWorker = variant.worker;
+
+    connect(tsneWorker, &TsneWorker::embeddingUpdate, this, [this, variantIndex](const std::vector<float> embeddingRecords, const int numPoints, const int numDismensions) {
+        emit embeddingUpdate(variantIndex, embeddingRecords, numPoints, numDismensions);
+    });
+
+    EmbeddingJob job;
+    job.context = this;
+    job.priority = _priority;
+
+    job.prepare = [tsneWorker](QThread* poolThread) -> void {
+        tsneWorker->changeThread(poolThread);
+    };
+
+    job.run = [tsneWorker]() -> void {
+        tsneWorker->compute();
+    };
+
+    job.cancelled = [this, variantIndex]() -> void {
+        if (variantIndex >= _variants.size() || _variants[variantIndex].jobId == 0)
+            return;
+
+        _variants[variantIndex].jobId = 0;
+        _variants[variantIndex].task->setAborted();
+
+        variantDone(variantIndex);
+    };
+
+    _numPendingVariants++;
+
+    variant.jobId = EmbeddingScheduler::instance().submit(std::move(job));
+}
+
+void TsneSweep::variantDone(std::size_t variantIndex)
+{
+    if (_numPendingVariants == 0)
+        return;
+
+    if (!_stopped)
+        emit variantFinished(variantIndex);
+
+    if (--_numPendingVariants == 0)
+        finishSweep();
+}
+
+void TsneSweep::finishSweep()
+{
+    qDebug() << "TsneSweep: " << (_stopped ? "aborted" : "finished") << " sweep of " << _variants.size() << " variants";
+
+    if (_task)
+    {
+        if (_stopped)
+            _task->setAborted();
+        else
+            _task->setFinished();
+    }
+
+    if (_stopped)
+        emit aborted();
+    else
+        emit finished();
+}
+
+void TsneSweep::deleteWorkers()
+{
+    // Take the variants first, such that cancellations and finished jobs below are not reported as part of the sweep
+    std::vector<Variant> variants = std::move(_variants);
+    _variants.clear();
+
+    const auto similarityJobId = _similarityJobId;
+    _similarityJobId = 0;
+    _numPendingVariants = 0;
+
+    auto& scheduler = EmbeddingScheduler::instance();
+
+    // The first variant computes the similarities, it stops at its next cancellation check
+    if (similarityJobId != 0 && !scheduler.cancel(similarityJobId) && scheduler.isRunning(similarityJobId))
+    {
+        if (!variants.empty() && variants.front().worker)
+            variants.front().worker->stop();
+
+        scheduler.wait(similarityJobId);
+    }
+
+    for (auto& variant : variants)
+    {
+        if (!variant.worker)
+            continue;
+
+        if (variant.jobId != 0 && !scheduler.cancel(variant.jobId) && scheduler.isRunning(variant.jobId))
+        {
+            variant.worker->stop();
+            scheduler.wait(variant.jobId);
+        }
+
+        variant.worker->changeThread(QThread::currentThread());
+        delete variant.worker;
+    }
+
+    _probabilityDistribution.reset();
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "EmbeddingScheduler.h"
+#include "KnnParameters.h"
+#include "TsneAnalysis.h"
+#include "TsneInputData.h"
+#include "TsneParameters.h"
+
+#include <Task.h>
+
+#include <QObject>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * TsneSweep
+ *
+ * Computes one t-SNE embedding per parameter variant, e.g. to compare the trajectories of different
+ * exaggeration factors, schedules or seeds. The kNN graph and the joint probability distribution are
+ * computed once, with the perplexity of the first variant, and shared by all gradient descents.
+ *
+ * Every gradient descent is a job of the embedding scheduler, such that the variants run concurrently
+ * on an equal share of the cores. Note that the gradient descent implementations keep their own copy of
+ * the probability distribution while they run.
+ */
+class TsneSweep : public QObject
+{
+    Q_OBJECT
+
+public:
+    TsneSweep();
+    ~TsneSweep() override;
+
+public: // Interactions
+
+    /**
+     * Compute the similarities of the input once and an embedding for each variant
+     * @param variants Parameters of the gradient descents, the perplexity of the first variant is used for all
+     * @param knnParameters Parameters of the aknn search
+     * @param input High-dimensional input data
+     * @param initEmbeddings Initial embedding per variant, an empty embedding keeps the default of the worker
+     */
+    void startComputation(const std::vector<TsneParameters>& variants, KnnParameters knnParameters, TsneInputData&& input, std::vector<std::vector<float>> initEmbeddings);
+
+    /**
+     * Compute an embedding for each variant from an existing joint probability distribution, e.g. an ensemble of seeds
+     * @param variants Parameters of the gradient descents
+     * @param jointProbDist Symmetrized probability distribution, shared (not copied) by the variants
+     * @param initEmbeddings Initial embedding per variant, an empty embedding keeps the default of the worker
+     */
+    void startComputation(const std::vector<TsneParameters>& variants, std::shared_ptr<const ProbDistMatrix> jointProbDist, std::vector<std::vector<float>> initEmbeddings);
+
+    /** Stop all running variants and drop the queued ones */
+    void stopComputation();
+
+public: // Setter
+    void setTask(mv::Task* task);
+    /** Scheduling priority of the sweep jobs */
+    void setPriority(int priority) { _priority = priority; };
+
+public: // Getter
+    std::size_t getNumVariants() const { return _variants.size(); }
+    bool isRunning() const { return _similarityJobId != 0 || _numPendingVariants > 0; }
+    /** Joint probability distribution shared by the variants, nullptr until it is computed */
+    std::shared_ptr<const ProbDistMatrix> getProbabilityDistribution() const { return _probabilityDistribution; }
+
+signals:
+    /** Same records as TsneAnalysis::embeddingUpdate, for the given variant */
+    void embeddingUpdate(std::size_t variant, const std::vector<float> embeddingRecords, const int numPoints, const int numDismensions);
+    void variantFinished(std::size_t variant);
+    void started();
+    void finished();
+    void aborted();
+
+private: // Internal
+    void createVariants(const std::vector<TsneParameters>& variants, std::vector<std::vector<float>> initEmbeddings);
+    void onSimilaritiesComputed();
+    void startGradientDescents();
+    void onJobFinished(EmbeddingScheduler::JobId jobId);
+    void submitVariant(std::size_t variantIndex);
+    void variantDone(std::size_t variantIndex);
+    void finishSweep();
+    void deleteWorkers();
+
+private:
+    struct Variant
+    {
+        TsneParameters              parameters;         /** Gradient descent parameters */
+        std::vector<float>          initEmbedding;      /** Initial embedding, empty for the default of the worker */
+        TsneWorker*                 worker = nullptr;   /** Computes the embedding */
+        std::unique_ptr<mv::Task>   task;               /** Progress of this variant */
+        EmbeddingScheduler::JobId   jobId = 0;          /** Scheduler job of the gradient descent */
+    };
+
+private:
+    std::vector<Variant>                    _variants;                  /** Variants of the current sweep */
+    std::shared_ptr<const ProbDistMatrix>   _probabilityDistribution;   /** Joint probability distribution shared by all variants */
+    mv::Task*                               _task;                      /** Parent task of the variant tasks */
+    EmbeddingScheduler::JobId               _similarityJobId;           /** Scheduler job of the similarity computation */
+    std::size_t                             _numPendingVariants;        /** Variants that are queued or running */
+    bool                                    _stopped;                   /** Whether the sweep was stopped */
+    int                                     _priority;                  /** Scheduling priority of the jobs */
+};
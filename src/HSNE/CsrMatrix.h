@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * CsrMatrix
+ *
+ * Compressed sparse row copy of a HDI sparse matrix (a vector of MapMemEff rows).
+ * All rows are stored back to back, which keeps repeated row scans,
+ * e.g. random walks or sub-graph extraction, cache friendly and free of allocations.
+ */
+class CsrMatrix
+{
+public:
+    CsrMatrix() = default;
+
+    template <typename SparseMatrix>
+    explicit CsrMatrix(const SparseMatrix& matrix) { assign(matrix); }
+
+    /** Copy a row-wise sparse matrix into CSR layout, rows are filled in parallel */
+    template <typename SparseMatrix>
+    void assign(const SparseMatrix& matrix)
+    {
+        const std::int64_t numRows = static_cast<std::int64_t>(matrix.size());
+
+        _rowOffsets.assign(numRows + 1, 0);
+
+        for (std::int64_t row = 0; row < numRows; row++)
+            _rowOffsets[row + 1] = _rowOffsets[row] + matrix[row].size();
+
+        _columns.resize(_rowOffsets.back());
+        _values.resize(_rowOffsets.back());
+
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (std::int64_t row = 0; row < numRows; row++)
+        {
+            std::uint64_t pos = _rowOffsets[row];
+            for (const auto& elem : matrix[row])
+            {
+                _columns[pos] = elem.first;
+                _values[pos] = elem.second;
+                pos++;
+            }
+        }
+    }
+
+    std::uint32_t numRows() const { return _rowOffsets.empty() ? 0 : static_cast<std::uint32_t>(_rowOffsets.size() - 1); }
+    std::uint64_t numNonZeros() const { return _columns.size(); }
+
+    std::uint64_t rowBegin(std::uint32_t row) const { return _rowOffsets[row]; }
+    std::uint64_t rowEnd(std::uint32_t row) const { return _rowOffsets[row + 1]; }
+    std::uint32_t rowSize(std::uint32_t row) const { return static_cast<std::uint32_t>(_rowOffsets[row + 1] - _rowOffsets[row]); }
+
+    const std::vector<std::uint32_t>& getColumns() const { return _columns; }
+    const std::vector<float>& getValues() const { return _values; }
+    std::vector<float>& getValues() { return _values; }
+
+private:
+    std::vector<std::uint64_t>  _rowOffsets;    /** Start of every row in _columns and _values, numRows + 1 entries */
+    std::vector<std::uint32_t>  _columns;       /** Column index of every non-zero entry */
+    std::vector<float>          _values;        /** Value of every non-zero entry */
+};
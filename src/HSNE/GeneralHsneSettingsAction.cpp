@@ -11,13 +11,15 @@ GeneralHsneSettingsAction::GeneralHsneSettingsAction(HsneSettingsAction& hsneSet
     _knnAlgorithmAction(this, "kNN Algorithm"),
     _distanceMetricAction(this, "Distance metric"),
     _numKnnAction(this, "Number of NN"),
-    _startAction(this, "Start")
+    _startAction(this, "Start"),
+    _exportProfileAction(this, "Export profile")
 {
     addAction(&_numScalesAction);
     addAction(&_knnAlgorithmAction);
     addAction(&_distanceMetricAction);
     addAction(&_numKnnAction);
     addAction(&_startAction);
+    addAction(&_exportProfileAction);
 
     _knnAlgorithmAction.setDefaultWidgetFlags(OptionAction::ComboBox);
     _numScalesAction.setDefaultWidgetFlags(IntegralAction::SpinBox);
@@ -30,7 +32,9 @@ GeneralHsneSettingsAction::GeneralHsneSettingsAction(HsneSettingsAction& hsneSet
     _numKnnAction.initialize(3, 300, 90);
 
     _numScalesAction.setToolTip("Number of hierarchy scales: e.g. 2 scales indicates one abstraction scale \nabove the data level, which is a scale itself.");
+    _knnAlgorithmAction.setToolTip("Library of the nearest neighbour search of the similarities.\nOnly FLANN with the Euclidean metric can be stopped while the neighbours are searched,\nwith HNSW and ANNOY a stop takes effect once the search has finished.");
     _startAction.setToolTip("Initialize the HSNE hierarchy and create an embedding");
+    _exportProfileAction.setToolTip("Save the timings of the phases of the hierarchy initialization as Chrome trace JSON, open it in Perfetto or chrome://tracing.");
 
     const auto updateNumScales = [this]() -> void {
         _hsneSettingsAction.getHsneParameters().setNumScales(_numScalesAction.getValue());
@@ -79,6 +83,7 @@ GeneralHsneSettingsAction::GeneralHsneSettingsAction(HsneSettingsAction& hsneSet
         _numScalesAction.setEnabled(enabled);
         _numKnnAction.setEnabled(enabled);
         _startAction.setEnabled(enabled);
+        _exportProfileAction.setEnabled(enabled);
     };
 
     connect(&_knnAlgorithmAction, &OptionAction::currentIndexChanged, this, [this, updateKnnAlgorithm]() {
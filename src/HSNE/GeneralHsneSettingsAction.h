@@ -34,6 +34,7 @@ public: // Action getters
     OptionAction& getDistanceMetricAction() { return _distanceMetricAction; }
     IntegralAction& getNumScalesAction() { return _numScalesAction; }
     TriggerAction& getStartAction() { return _startAction; }
+    TriggerAction& getExportProfileAction() { return _exportProfileAction; }
 
 public: // Serialization
 
@@ -56,4 +57,5 @@ protected:
     OptionAction            _distanceMetricAction;                  /** Distance metric action */
     IntegralAction          _numKnnAction;                          /** Number of Knn action */
     TriggerAction           _startAction;                           /** Start action */
+    TriggerAction           _exportProfileAction;                   /** Export the phase timings of the hierarchy initialization as a trace */
 };
@@ -16,7 +16,8 @@ HierarchyConstructionSettingsAction::HierarchyConstructionSettingsAction(HsneSet
     _useMonteCarloSamplingAction(this, "Use Monte Carlo sampling"),
     _seedAction(this, "Random seed"),
     _saveHierarchyToDiskAction(this, "Save hierarchy to disk"),
-    _saveHierarchyToProjectAction(this, "Save hierarchy to project")
+    _saveHierarchyToProjectAction(this, "Save hierarchy to project"),
+    _cacheSizeLimitAction(this, "Cache size limit (MB)")
 {
     addAction(&_numWalksForLandmarkSelectionAction);
     addAction(&_numWalksForLandmarkSelectionThresholdAction);
@@ -28,6 +29,7 @@ HierarchyConstructionSettingsAction::HierarchyConstructionSettingsAction(HsneSet
     addAction(&_useMonteCarloSamplingAction);
     addAction(&_saveHierarchyToDiskAction);
     addAction(&_saveHierarchyToProjectAction);
+    addAction(&_cacheSizeLimitAction);
 
     _numWalksForLandmarkSelectionAction.setDefaultWidgetFlags(IntegralAction::SpinBox);
     _numWalksForLandmarkSelectionThresholdAction.setDefaultWidgetFlags(IntegralAction::SpinBox);
@@ -39,6 +41,7 @@ HierarchyConstructionSettingsAction::HierarchyConstructionSettingsAction(HsneSet
     _seedAction.setDefaultWidgetFlags(IntegralAction::SpinBox);
     _saveHierarchyToDiskAction.setDefaultWidgetFlags(ToggleAction::CheckBox);
     _saveHierarchyToProjectAction.setDefaultWidgetFlags(ToggleAction::CheckBox);
+    _cacheSizeLimitAction.setDefaultWidgetFlags(IntegralAction::SpinBox);
 
     _numWalksForLandmarkSelectionAction.setToolTip("Number of walks for landmark selection");
     _numWalksForLandmarkSelectionThresholdAction.setToolTip("Number of walks for landmark selection");
@@ -50,6 +53,7 @@ HierarchyConstructionSettingsAction::HierarchyConstructionSettingsAction(HsneSet
     _seedAction.setToolTip("Random seed for initialization");
     _saveHierarchyToDiskAction.setToolTip("Save (load) computed hierarchy to (from) disk. \nWhen computing HSNE again with the same settings, \nthe hierarchy is loaded instead of recomputed");
     _saveHierarchyToProjectAction.setToolTip("Save computed hierarchy when saving a project. \nThis enables selection refinements \nafter loading projects");
+    _cacheSizeLimitAction.setToolTip("Maximum size of the hierarchy cache on disk in MB. \nThe least recently used hierarchies are removed first. \n0 disables the limit");
 
     const auto& hsneParameters = hsneSettingsAction.getHsneParameters();
 
@@ -63,6 +67,7 @@ HierarchyConstructionSettingsAction::HierarchyConstructionSettingsAction(HsneSet
     _seedAction.initialize(-1000, 1000, hsneParameters.getSeed());
     _saveHierarchyToDiskAction.setChecked(hsneParameters.getSaveHierarchyToDisk());
     _saveHierarchyToProjectAction.setChecked(true);
+    _cacheSizeLimitAction.initialize(0, 1000000, hsneParameters.getCacheSizeLimit());
     
     collapse();
 
@@ -102,6 +107,10 @@ HierarchyConstructionSettingsAction::HierarchyConstructionSettingsAction(HsneSet
         _hsneSettingsAction.getHsneParameters().setSaveHierarchyToDisk(_saveHierarchyToDiskAction.isChecked());
     };
 
+    const auto updateCacheSizeLimit = [this]() -> void {
+        _hsneSettingsAction.getHsneParameters().setCacheSizeLimit(_cacheSizeLimitAction.getValue());
+    };
+
     const auto updateReadOnly = [this]() -> void {
         const auto enabled = !isReadOnly();
 
@@ -151,6 +160,10 @@ HierarchyConstructionSettingsAction::HierarchyConstructionSettingsAction(HsneSet
         updateSaveHierarchyToDiskAction();
     });
 
+    connect(&_cacheSizeLimitAction, &IntegralAction::valueChanged, this, [this, updateCacheSizeLimit]() {
+        updateCacheSizeLimit();
+    });
+
     connect(this, &GroupAction::readOnlyChanged, this, [this, updateReadOnly](const bool& readOnly) {
         updateReadOnly();
     });
@@ -164,6 +177,7 @@ HierarchyConstructionSettingsAction::HierarchyConstructionSettingsAction(HsneSet
     updateUseMonteCarloSampling();
     updateSeed();
     updateSaveHierarchyToDiskAction();
+    updateCacheSizeLimit();
     updateReadOnly();
 }
 
@@ -181,6 +195,9 @@ void HierarchyConstructionSettingsAction::fromVariantMap(const QVariantMap& vari
     _seedAction.fromParentVariantMap(variantMap);
     _saveHierarchyToDiskAction.fromParentVariantMap(variantMap);
     _saveHierarchyToProjectAction.fromParentVariantMap(variantMap);
+
+    if (variantMap.contains(_cacheSizeLimitAction.getSerializationName()))
+        _cacheSizeLimitAction.fromParentVariantMap(variantMap);
 }
 
 QVariantMap HierarchyConstructionSettingsAction::toVariantMap() const
@@ -197,6 +214,7 @@ QVariantMap HierarchyConstructionSettingsAction::toVariantMap() const
     _seedAction.insertIntoVariantMap(variantMap);
     _saveHierarchyToDiskAction.insertIntoVariantMap(variantMap);
     _saveHierarchyToProjectAction.insertIntoVariantMap(variantMap);
+    _cacheSizeLimitAction.insertIntoVariantMap(variantMap);
 
     return variantMap;
 }
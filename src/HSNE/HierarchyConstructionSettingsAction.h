@@ -40,6 +40,7 @@ public: // Action getters
     IntegralAction& getSeedAction() { return _seedAction; }
     ToggleAction& getSaveHierarchyToDiskAction() { return _saveHierarchyToDiskAction; }
     ToggleAction& getSaveHierarchyToProjectAction() { return _saveHierarchyToProjectAction; }
+    IntegralAction& getCacheSizeLimitAction() { return _cacheSizeLimitAction; }
 
 public: // Serialization
 
@@ -67,4 +68,5 @@ protected:
     IntegralAction          _seedAction;                                        /** Random seed action */
     ToggleAction            _saveHierarchyToDiskAction;                         /** Save computed hierarchy to disk action */
     ToggleAction            _saveHierarchyToProjectAction;                      /** Save computed hierarchy to project action */
+    IntegralAction          _cacheSizeLimitAction;                              /** Size limit of the hierarchy cache on disk action */
 };
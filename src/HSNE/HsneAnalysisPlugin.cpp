@@ -16,7 +16,10 @@
 
 #include "hdi/dimensionality_reduction/hierarchical_sne.h"
 
+#include <QFileDialog>
+
 #include <fstream>
+#include <numeric>
 
 Q_PLUGIN_METADATA(IID "nl.tudelft.HsneAnalysisPlugin")
 
@@ -36,6 +39,7 @@ HsneAnalysisPlugin::HsneAnalysisPlugin(const PluginFactory* factory) :
 
 HsneAnalysisPlugin::~HsneAnalysisPlugin()
 {
+    _hierarchy->cancel();              // Stop a running initialization at its next cancellation check
     _hierarchyThread.quit();           // Signal the thread to quit gracefully
     if (!_hierarchyThread.wait(500))   // Wait for the thread to actually finish
         _hierarchyThread.terminate();  // Terminate thread after 0.5 seconds
@@ -162,6 +166,15 @@ void HsneAnalysisPlugin::init()
         computeTopLevelEmbedding();
     });
 
+    // A stopped initialization leaves no hierarchy to embed, only the settings are released
+    connect(_hierarchy.get(), &HsneHierarchy::aborted, this, [this]() {
+        _hsneSettingsAction->getGeneralHsneSettingsAction().setReadOnly(false);
+        _hsneSettingsAction->getHierarchyConstructionSettingsAction().setReadOnly(false);
+        _hsneSettingsAction->getTopLevelScaleAction().setReadOnly(false);
+        _hsneSettingsAction->getGradientDescentSettingsAction().setReadOnly(false);
+        _hsneSettingsAction->getKnnSettingsAction().setReadOnly(false);
+    });
+
     connect(&_hsneSettingsAction->getGeneralHsneSettingsAction().getStartAction(), &TriggerAction::triggered, this, [this](bool toggled) {
 
         // Create a warning dialog if there are already refined scales
@@ -195,6 +208,22 @@ void HsneAnalysisPlugin::init()
 
     });
 
+    connect(&_hsneSettingsAction->getGeneralHsneSettingsAction().getExportProfileAction(), &TriggerAction::triggered, this, [this]() {
+        if (!_hierarchy->isInitialized())
+        {
+            qWarning() << "HsneAnalysisPlugin: nothing to export, initialize the hierarchy first";
+            return;
+        }
+
+        const auto fileName = QFileDialog::getSaveFileName(nullptr, "Export profile", "hsne_profile.json", "Chrome trace (*.json)");
+
+        if (fileName.isEmpty())
+            return;
+
+        if (!_hierarchy->getProfiler().exportChromeTrace(fileName.toStdString()))
+            qWarning() << "HsneAnalysisPlugin: could not write profile to " << fileName;
+    });
+
     connect(&_tsneAnalysis, &TsneAnalysis::started, this, [this, &computationAction, updateComputationAction]() {
         computationAction.getRunningAction().setChecked(true);
         updateComputationAction();
@@ -279,8 +308,7 @@ void HsneAnalysisPlugin::computeTopLevelEmbedding()
         }
         else
         {
-            std::vector<unsigned int> globalIndices;
-            inputDataset->getGlobalIndices(globalIndices);
+            const auto& globalIndices = _hierarchy->getGlobalIndices();
             for (uint32_t i = 0; i < numLandmarks; i++)
                 selectionDataset->indices[i] = globalIndices[topScale._landmark_to_original_data_idx[i]];
         }
@@ -296,36 +324,10 @@ void HsneAnalysisPlugin::computeTopLevelEmbedding()
 
         // Add linked selection between the upper embedding and the bottom layer
         {
-            LandmarkMap& landmarkMap = _hierarchy->getInfluenceHierarchy().getMap()[topScaleIndex];
-
-            mv::SelectionMap mapping;
-            auto& selectionMap = mapping.getMap();
+            std::vector<uint32_t> topScaleLandmarks(numLandmarks);
+            std::iota(topScaleLandmarks.begin(), topScaleLandmarks.end(), 0);
 
-            if (inputDataset->isFull())
-            {
-                std::vector<unsigned int> globalIndices;
-                _selectionHelperData->getGlobalIndices(globalIndices);
-
-                for (unsigned int i = 0; i < landmarkMap.size(); i++)
-                {
-                    selectionMap[globalIndices[i]] = landmarkMap[i];
-                }
-            }
-            else
-            {
-                std::vector<unsigned int> globalIndices;
-                inputDataset->getGlobalIndices(globalIndices);
-                for (unsigned int i = 0; i < landmarkMap.size(); i++)
-                {
-                    std::vector<unsigned int> bottomMap = landmarkMap[i];
-                    for (unsigned int j = 0; j < bottomMap.size(); j++)
-                    {
-                        bottomMap[j] = globalIndices[bottomMap[j]];
-                    }
-                    auto bottomLevelIdx = _hierarchy->getScale(topScaleIndex)._landmark_to_original_data_idx[i];
-                    selectionMap[globalIndices[bottomLevelIdx]] = bottomMap;
-                }
-            }
+            mv::SelectionMap mapping = _hierarchy->getSelectionMapping(topScaleIndex, topScaleLandmarks);
 
             embeddingDataset->addLinkedData(inputDataset, mapping);
         }
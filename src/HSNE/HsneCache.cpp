@@ -0,0 +1,284 @@
+#include "HsneCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include <QStandardPaths>
+#include <QString>
+
+namespace
+{
+    // set cache folder name
+    constexpr auto _CACHE_SUBFOLDER_ = "hsne-cache";
+
+    // Number of bytes hashed by a single thread at once
+    constexpr std::size_t _HASH_BLOCK_SIZE_ = 1 << 20;
+
+    constexpr std::uint64_t _PRIME64_1_ = 0x9E3779B185EBCA87ull;
+    constexpr std::uint64_t _PRIME64_2_ = 0xC2B2AE3D27D4EB4Full;
+    constexpr std::uint64_t _PRIME64_3_ = 0x165667B19E3779F9ull;
+    constexpr std::uint64_t _PRIME64_4_ = 0x85EBCA77C2B2AE63ull;
+    constexpr std::uint64_t _PRIME64_5_ = 0x27D4EB2F165667C5ull;
+
+    inline std::uint64_t rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    inline std::uint64_t read64(const unsigned char* p) { std::uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+    inline std::uint32_t read32(const unsigned char* p) { std::uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+    inline std::uint64_t round(std::uint64_t acc, std::uint64_t input)
+    {
+        acc += input * _PRIME64_2_;
+        acc = rotl(acc, 31);
+        return acc * _PRIME64_1_;
+    }
+
+    inline std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t val)
+    {
+        acc ^= round(0, val);
+        return acc * _PRIME64_1_ + _PRIME64_4_;
+    }
+
+    // XXH64 of a byte range
+    std::uint64_t xxh64(const void* input, std::size_t length, std::uint64_t seed)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(input);
+        const unsigned char* const end = p + length;
+        std::uint64_t h;
+
+        if (length >= 32)
+        {
+            const unsigned char* const limit = end - 32;
+            std::uint64_t v1 = seed + _PRIME64_1_ + _PRIME64_2_;
+            std::uint64_t v2 = seed + _PRIME64_2_;
+            std::uint64_t v3 = seed;
+            std::uint64_t v4 = seed - _PRIME64_1_;
+
+            do {
+                v1 = round(v1, read64(p)); p += 8;
+                v2 = round(v2, read64(p)); p += 8;
+                v3 = round(v3, read64(p)); p += 8;
+                v4 = round(v4, read64(p)); p += 8;
+            } while (p <= limit);
+
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = mergeRound(h, v1);
+            h = mergeRound(h, v2);
+            h = mergeRound(h, v3);
+            h = mergeRound(h, v4);
+        }
+        else
+        {
+            h = seed + _PRIME64_5_;
+        }
+
+        h += static_cast<std::uint64_t>(length);
+
+        while (p + 8 <= end)
+        {
+            h ^= round(0, read64(p));
+            h = rotl(h, 27) * _PRIME64_1_ + _PRIME64_4_;
+            p += 8;
+        }
+
+        if (p + 4 <= end)
+        {
+            h ^= static_cast<std::uint64_t>(read32(p)) * _PRIME64_1_;
+            h = rotl(h, 23) * _PRIME64_2_ + _PRIME64_3_;
+            p += 4;
+        }
+
+        while (p < end)
+        {
+            h ^= (*p) * _PRIME64_5_;
+            h = rotl(h, 11) * _PRIME64_1_;
+            p++;
+        }
+
+        h ^= h >> 33;
+        h *= _PRIME64_2_;
+        h ^= h >> 29;
+        h *= _PRIME64_3_;
+        h ^= h >> 32;
+
+        return h;
+    }
+
+    // Number of InUse markers per entry key, shared by all hierarchies of the process
+    std::mutex& inUseMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    std::map<std::string, std::uint32_t>& inUseCounts()
+    {
+        static std::map<std::string, std::uint32_t> counts;
+        return counts;
+    }
+
+    // Files of a cache entry start with the key, followed by an underscore and the file type
+    std::string entryKey(const std::filesystem::path& file)
+    {
+        const auto fileName = file.filename().string();
+        return fileName.substr(0, fileName.find('_'));
+    }
+}
+
+HsneCache::InUse::InUse(const std::string& key) :
+    _key(key)
+{
+    std::lock_guard<std::mutex> lock(inUseMutex());
+    inUseCounts()[_key]++;
+}
+
+HsneCache::InUse::~InUse()
+{
+    std::lock_guard<std::mutex> lock(inUseMutex());
+
+    auto& counts = inUseCounts();
+    const auto it = counts.find(_key);
+
+    if (it != counts.end() && --it->second == 0)
+        counts.erase(it);
+}
+
+bool HsneCache::isInUse(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(inUseMutex());
+    return inUseCounts().count(key) > 0;
+}
+
+std::uint64_t HsneCache::hashData(const float* data, std::size_t numValues)
+{
+    const auto bytes = reinterpret_cast<const unsigned char*>(data);
+    const std::size_t numBytes = numValues * sizeof(float);
+    const std::int64_t numBlocks = static_cast<std::int64_t>((numBytes + _HASH_BLOCK_SIZE_ - 1) / _HASH_BLOCK_SIZE_);
+
+    std::vector<std::uint64_t> blockHashes(numBlocks);
+
+#pragma omp parallel for schedule(static)
+    for (std::int64_t block = 0; block < numBlocks; block++)
+    {
+        const std::size_t begin = static_cast<std::size_t>(block) * _HASH_BLOCK_SIZE_;
+        const std::size_t length = std::min(_HASH_BLOCK_SIZE_, numBytes - begin);
+
+        blockHashes[block] = xxh64(bytes + begin, length, static_cast<std::uint64_t>(block));
+    }
+
+    // The total length is part of the seed, such that trailing zero blocks change the hash
+    return xxh64(blockHashes.data(), blockHashes.size() * sizeof(std::uint64_t), static_cast<std::uint64_t>(numBytes));
+}
+
+std::uint64_t HsneCache::hashString(const std::string& text)
+{
+    return xxh64(text.data(), text.size(), 0);
+}
+
+std::string HsneCache::makeKey(std::uint64_t dataHash, std::uint64_t parametersHash)
+{
+    std::ostringstream key;
+    key << std::hex << std::setfill('0') << std::setw(16) << dataHash << std::setw(16) << parametersHash;
+    return key.str();
+}
+
+std::filesystem::path HsneCache::getCacheDirectory()
+{
+    const auto cacheLocation = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    if (cacheLocation.isEmpty())
+        return std::filesystem::current_path() / _CACHE_SUBFOLDER_;
+
+    return std::filesystem::path(cacheLocation.toStdWString()) / _CACHE_SUBFOLDER_;
+}
+
+void HsneCache::remove(const std::filesystem::path& cacheDirectory, const std::string& key)
+{
+    std::error_code ec;
+    if (key.empty() || !std::filesystem::exists(cacheDirectory, ec))
+        return;
+
+    std::vector<std::filesystem::path> files;
+    for (const auto& file : std::filesystem::directory_iterator(cacheDirectory, ec))
+        if (file.is_regular_file(ec) && entryKey(file.path()) == key)
+            files.push_back(file.path());
+
+    for (const auto& file : files)
+        std::filesystem::remove(file, ec);
+
+    if (!files.empty())
+        std::cout << "HsneCache: removed " << key << std::endl;
+}
+
+void HsneCache::touch(const std::filesystem::path& cacheDirectory, const std::string& key)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(cacheDirectory, ec))
+        return;
+
+    const auto now = std::filesystem::file_time_type::clock::now();
+
+    for (const auto& file : std::filesystem::directory_iterator(cacheDirectory, ec))
+        if (file.is_regular_file(ec) && entryKey(file.path()) == key)
+            std::filesystem::last_write_time(file.path(), now, ec);
+}
+
+void HsneCache::enforceSizeLimit(const std::filesystem::path& cacheDirectory, std::uintmax_t maxBytes, const std::string& keepKey)
+{
+    std::error_code ec;
+    if (maxBytes == 0 || !std::filesystem::exists(cacheDirectory, ec))
+        return;
+
+    struct Entry
+    {
+        std::uintmax_t                      size = 0;
+        std::filesystem::file_time_type     lastUsed = std::filesystem::file_time_type::min();
+        std::vector<std::filesystem::path>  files;
+    };
+
+    // Group files by entry, an entry is as recent as its most recently used file
+    std::map<std::string, Entry> entries;
+    std::uintmax_t totalSize = 0;
+
+    for (const auto& file : std::filesystem::directory_iterator(cacheDirectory, ec))
+    {
+        if (!file.is_regular_file(ec))
+            continue;
+
+        auto& entry = entries[entryKey(file.path())];
+        const auto size = file.file_size(ec);
+
+        entry.size += size;
+        entry.lastUsed = std::max(entry.lastUsed, file.last_write_time(ec));
+        entry.files.push_back(file.path());
+        totalSize += size;
+    }
+
+    if (totalSize <= maxBytes)
+        return;
+
+    std::vector<std::pair<std::string, Entry*>> lru;
+    for (auto& [key, entry] : entries)
+        if (key != keepKey && !isInUse(key))
+            lru.emplace_back(key, &entry);
+
+    std::sort(lru.begin(), lru.end(), [](const auto& a, const auto& b) { return a.second->lastUsed < b.second->lastUsed; });
+
+    for (const auto& [key, entry] : lru)
+    {
+        if (totalSize <= maxBytes)
+            break;
+
+        std::cout << "HsneCache: evict " << key << " (" << entry->size / (1024 * 1024) << " MB)" << std::endl;
+
+        for (const auto& file : entry->files)
+            std::filesystem::remove(file, ec);
+
+        totalSize -= entry->size;
+    }
+}
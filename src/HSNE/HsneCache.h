@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/**
+ * HsneCache
+ *
+ * Helpers for the content addressed HSNE hierarchy cache.
+ *
+ * Cache entries are named by a key derived from a hash of the (enabled dimensions of the) input data
+ * and a hash of the HSNE parameters. All files of an entry start with the key, e.g. <key>_hierarchy.hsne.
+ * Entries are kept in a single cache directory that is shared between projects, its size is limited
+ * by evicting the least recently used entries. Entries that are in use in this process are never evicted.
+ */
+class HsneCache
+{
+public:
+    /**
+     * Marks an entry as in use for its lifetime, e.g. while scales are paged in from the entry's files.
+     * Entries are counted, several hierarchies may use the same entry.
+     */
+    class InUse
+    {
+    public:
+        explicit InUse(const std::string& key);
+        ~InUse();
+
+        InUse(const InUse&) = delete;
+        InUse& operator=(const InUse&) = delete;
+
+        const std::string& getKey() const { return _key; }
+
+    private:
+        std::string     _key;       /** Key of the entry in use */
+    };
+
+    /** Whether an InUse marker for the entry exists in this process */
+    static bool isInUse(const std::string& key);
+
+    /**
+     * Hash of a float array. The data is split into fixed size blocks which are hashed (XXH64) in parallel,
+     * the block hashes are then combined in block order, so the result does not depend on the number of threads
+     */
+    static std::uint64_t hashData(const float* data, std::size_t numValues);
+
+    /** XXH64 hash of a string */
+    static std::uint64_t hashString(const std::string& text);
+
+    /** Cache key of a data and parameter hash */
+    static std::string makeKey(std::uint64_t dataHash, std::uint64_t parametersHash);
+
+    /** Cache directory shared by all projects */
+    static std::filesystem::path getCacheDirectory();
+
+    /** Remove all files of the entry with the given key, e.g. when the entry is damaged */
+    static void remove(const std::filesystem::path& cacheDirectory, const std::string& key);
+
+    /** Mark the entry with the given key as most recently used */
+    static void touch(const std::filesystem::path& cacheDirectory, const std::string& key);
+
+    /**
+     * Remove the least recently used entries until the cache directory is smaller than maxBytes, entries in use are kept
+     * @param cacheDirectory Cache directory
+     * @param maxBytes Size limit in bytes, 0 disables the limit
+     * @param keepKey Entry that is never removed, e.g. the one that was just written
+     */
+    static void enforceSizeLimit(const std::filesystem::path& cacheDirectory, std::uintmax_t maxBytes, const std::string& keepKey);
+};
@@ -1,27 +1,38 @@
 #include "HsneHierarchy.h"
 
+#include "HsneCache.h"
 #include "HsneParameters.h"
+#include "HsneRandomWalks.h"
 #include "KnnParameters.h"
+#include "KnnSimilarities.h"
+#include "TsneInputData.h"
 
 #include "DataHierarchyItem.h"
-#include "ImageData/Images.h"
 
+#include "hdi/data/io.h"
 #include "hdi/utils/cout_log.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <numeric>
+#include <sstream>
 
 #include "nlohmann/json.hpp"
 
-#include <QFileInfo>
 #include <QString>
 
 // set suffix strings for cache
-constexpr auto _CACHE_SUBFOLDER_ = "hsne-cache";
-constexpr auto _HIERARCHY_CACHE_EXTENSION_ = "_hierarchy.hsne";
-constexpr auto _INFLUENCE_TOPDOWN_CACHE_EXTENSION_ = "_influence-tp-hierarchy.hsne";
+constexpr auto _SCALES_CACHE_EXTENSION_ = "_scales.hsne";
 constexpr auto _PARAMETERS_CACHE_EXTENSION_ = "_parameters.hsne";
-constexpr auto _PARAMETERS_CACHE_VERSION_ = "1.0";
+constexpr auto _PARAMETERS_CACHE_VERSION_ = "2.0";
+
+// header of the scale-indexed cache file
+constexpr char _SCALES_CACHE_MAGIC_[4] = { 'H', 'S', 'N', 'C' };
+constexpr std::uint32_t _SCALES_CACHE_FORMAT_VERSION_ = 2;
+
+// maximum number of steps of a random walk when computing the area of influence
+constexpr std::uint32_t _AOI_MAX_WALK_LENGTH_ = 200;
 
 namespace
 {
@@ -46,6 +57,123 @@ namespace
         params._num_neighbors = parameters.getNumNearestNeighbors();
         return params;
     }
+
+    // Inverse of setParameters, the nearest neighbour search of the data scale
+    KnnParameters getKnnParameters(const Hsne::Parameters& params)
+    {
+        KnnParameters knnParameters;
+        knnParameters.setKnnAlgorithm(params._aknn_algorithm);
+        knnParameters.setKnnDistanceMetric(params._aknn_metric);
+        knnParameters.setAnnoyNumChecks(static_cast<int>(params._aknn_num_checks));
+        knnParameters.setAnnoyNumTrees(static_cast<int>(params._aknn_num_trees));
+        knnParameters.setHNSWm(static_cast<int>(params._aknn_algorithmP1));
+        knnParameters.setHNSWef(static_cast<int>(params._aknn_algorithmP2));
+        return knnParameters;
+    }
+
+    template <typename T>
+    void writeVector(std::ofstream& stream, const std::vector<T>& vec)
+    {
+        const std::uint64_t size = vec.size();
+        stream.write((const char*)&size, sizeof(size));
+        if (size > 0)
+            stream.write((const char*)vec.data(), size * sizeof(T));
+    }
+
+    // Sparse matrix as its number of rows followed by every row as a vector of (column, value) entries
+    void writeSparseMatrix(std::ofstream& stream, const HsneMatrix& matrix)
+    {
+        const std::uint64_t numRows = matrix.size();
+        stream.write((const char*)&numRows, sizeof(numRows));
+
+        std::vector<std::pair<std::uint32_t, float>> entries;
+        for (const auto& row : matrix)
+        {
+            entries.assign(row.begin(), row.end());
+            writeVector(stream, entries);
+        }
+    }
+
+    /**
+     * Reads a section of the scale-indexed cache file. Every read is checked against the size of the section
+     * in the table of contents, such that sizes read from a corrupt file never cause reads beyond the section or huge allocations
+     */
+    class SectionReader
+    {
+    public:
+        SectionReader(std::ifstream& stream, std::uint64_t size) :
+            _stream(stream),
+            _remaining(size)
+        {
+        }
+
+        bool read(void* data, std::uint64_t numBytes)
+        {
+            if (numBytes > _remaining)
+                return false;
+
+            _stream.read((char*)data, static_cast<std::streamsize>(numBytes));
+            _remaining -= numBytes;
+
+            return static_cast<bool>(_stream);
+        }
+
+        template <typename T>
+        bool readVector(std::vector<T>& vec)
+        {
+            std::uint64_t size = 0;
+            if (!read(&size, sizeof(size)) || size > _remaining / sizeof(T))
+                return false;
+
+            vec.resize(size);
+            return size == 0 || read(vec.data(), size * sizeof(T));
+        }
+
+        /** Columns of all entries must be smaller than numColumns */
+        bool readSparseMatrix(HsneMatrix& matrix, std::uint64_t numColumns)
+        {
+            std::uint64_t numRows = 0;
+            if (!read(&numRows, sizeof(numRows)) || numRows > _remaining / sizeof(std::uint64_t))
+                return false;
+
+            matrix.clear();
+            matrix.resize(numRows);
+
+            for (auto& row : matrix)
+            {
+                auto& entries = row.memory();
+
+                if (!readVector(entries))
+                    return false;
+
+                for (const auto& entry : entries)
+                    if (entry.first >= numColumns)
+                        return false;
+            }
+
+            return true;
+        }
+
+        /** Whether the whole section was read */
+        bool atEnd() const { return _remaining == 0; }
+
+    private:
+        std::ifstream&  _stream;        /** Cache file, positioned in the section */
+        std::uint64_t   _remaining;     /** Bytes of the section that are not read yet */
+    };
+
+    // All parameters that influence the hierarchy, except for the number of scales
+    std::string cacheParametersString(const Hsne::Parameters& params, unsigned int numPoints, unsigned int numDimensions)
+    {
+        std::ostringstream ss;
+        ss << _PARAMETERS_CACHE_VERSION_ << ';' << numPoints << ';' << numDimensions << ';'
+           << params._aknn_algorithm << ';' << params._aknn_metric << ';' << params._num_neighbors << ';'
+           << params._aknn_num_checks << ';' << params._aknn_num_trees << ';' << params._aknn_algorithmP1 << ';' << params._aknn_algorithmP2 << ';'
+           << params._out_of_core_computation << ';' << params._num_walks_per_landmark << ';' << params._mcmcs_num_walks << ';'
+           << params._mcmcs_landmark_thresh << ';' << params._mcmcs_walk_length << ';' << params._transition_matrix_prune_thresh << ';'
+           << params._hard_cut_off << ';' << params._hard_cut_off_percentage << ';' << params._seed << ';' << params._monte_carlo_sampling;
+        return ss.str();
+    }
 }
 
 /**
@@ -53,13 +181,27 @@ namespace
  */
 void InfluenceHierarchy::initialize(HsneHierarchy& hierarchy)
 {
+    extend(hierarchy, 1);
+}
+
+/**
+ * Compute the landmark maps of all scales starting at firstScale, lower scales are kept as they are
+ */
+void InfluenceHierarchy::extend(HsneHierarchy& hierarchy, int firstScale)
+{
+    firstScale = std::max(firstScale, 1);
+
+    // The influence on the data points is computed through all scales
+    hierarchy.loadAllScales();
+
     _influenceMap.resize(hierarchy.getNumScales());
 
-    // For every scale except the bottom scale resize the landmark map to the number of landmarks
-    for (int scale = 1; scale < hierarchy.getNumScales(); scale++)
+    // For every new scale reset the landmark map to the number of landmarks
+    for (int scale = firstScale; scale < hierarchy.getNumScales(); scale++)
     {
         int numLandmarks = hierarchy.getScale(scale).size();
 
+        _influenceMap[scale].clear();
         _influenceMap[scale].resize(numLandmarks);
     }
 
@@ -70,6 +212,9 @@ void InfluenceHierarchy::initialize(HsneHierarchy& hierarchy)
 #pragma omp parallel for
     for (int i = 0; i < numDataPoints; i++)
     {
+        if (hierarchy.isCancelled())
+            continue;
+
         std::vector<std::unordered_map<unsigned int, float>> influence;
 
         float thresh = 0.01f;
@@ -83,7 +228,7 @@ void InfluenceHierarchy::initialize(HsneHierarchy& hierarchy)
             redo = 0;
             if (tries++ < 3)
             {
-                for (int scale = 1; scale < hierarchy.getNumScales(); scale++)
+                for (int scale = firstScale; scale < hierarchy.getNumScales(); scale++)
                 {
                     if (influence[scale].size() < 1)
                     {
@@ -100,7 +245,7 @@ void InfluenceHierarchy::initialize(HsneHierarchy& hierarchy)
         }
         //////
 
-        for (int scale = 1; scale < hierarchy.getNumScales(); scale++)
+        for (int scale = firstScale; scale < hierarchy.getNumScales(); scale++)
         {
             float maxInfluence = 0;
             int topInfluencingLandmark = -1;
@@ -142,6 +287,7 @@ void HsneHierarchy::setDataAndParameters(const mv::Dataset<Points>& inputData, c
     _params = setParameters(parameters, knnParameters);
 
     _saveHierarchyToDisk = parameters.getSaveHierarchyToDisk();
+    _cacheSizeLimit = static_cast<std::uintmax_t>(parameters.getCacheSizeLimit()) * 1024 * 1024;
 
     // Save enabled dimensions and data set to retrieve data
     _inputData = inputData;
@@ -156,34 +302,19 @@ void HsneHierarchy::setDataAndParameters(const mv::Dataset<Points>& inputData, c
     _numPoints = _inputData->getNumPoints();
     _numDimensions = numEnabledDimensions;
 
-    // Check for source data file path
-    std::string inputLoadPath = std::string();
-    {
-        mv::Dataset<Images> inputdataImage = nullptr;
-        for (auto childHierarchyItem : _inputData->getDataHierarchyItem().getChildren()) {
+    // Linked selections of subsets are expressed in global indices, fetch the table once instead of on every refinement
+    // Set here rather than in initialize(), a hierarchy loaded with a project is not initialized
+    _globalIndices.clear();
+    if (!_inputData->isFull())
+        _inputData->getGlobalIndices(_globalIndices);
 
-            if (childHierarchyItem->getDataType() == ImageType) {
-                inputdataImage = childHierarchyItem->getDataset();
-                break;
-            }
-        }
-
-        if (inputdataImage.isValid())
-        {
-            auto imageFilePath = inputdataImage->getImageFilePaths();
-            if(!imageFilePath.isEmpty())
-                inputLoadPath = QFileInfo(imageFilePath.first()).dir().absolutePath().toStdString();
-        }
-    }
-
-    // Set cache paths
-    if (inputLoadPath == std::string())
-        _cachePath = std::filesystem::current_path() / _CACHE_SUBFOLDER_;
-    else
-        _cachePath = std::filesystem::path(inputLoadPath) / _CACHE_SUBFOLDER_;
+    // Cache entries are shared between projects, the file names are set once the data is hashed
+    _cachePath = HsneCache::getCacheDirectory();
 
     _inputDataName = _inputData->text().toStdString();
-    _cachePathFileName = _cachePath / _inputDataName;
+    _cacheKey.clear();
+    _cachePathFileName.clear();
+    resetLazyCache();
 
     _hsne = std::make_unique<Hsne>();
 }
@@ -198,6 +329,26 @@ void HsneHierarchy::initParentTask()
     _parentTask->setProgressMode(mv::Task::ProgressMode::Manual);
     _parentTask->setRunning();
     _parentTask->setProgress(.0f);
+
+    _cancellation.reset();
+
+    connect(_parentTask, &mv::Task::requestAbort, this, &HsneHierarchy::cancel, static_cast<Qt::ConnectionType>(Qt::DirectConnection | Qt::UniqueConnection));
+}
+
+void HsneHierarchy::abortInitialization()
+{
+    std::cout << "Stopped the initialization of the HSNE hierarchy" << std::endl;
+
+    // Release the partial hierarchy right away
+    _isInit = false;
+    _hsne = std::make_unique<Hsne>();
+    _influenceHierarchy.getMap().clear();
+    resetLazyCache();
+
+    _parentTask->setAborted();
+
+    emit aborted();
+    this->moveToThread(QCoreApplication::instance()->thread());
 }
 
 void HsneHierarchy::initialize()
@@ -206,11 +357,112 @@ void HsneHierarchy::initialize()
 
     hdi::utils::CoutLog log;
 
+    _profiler.reset();
+
+    // Loading the cache sets the number of scales to the number of cached scales
+    const int numRequestedScales = _numScales;
+
+    // Load data and enabled dimensions, the data of a full data set with all dimensions enabled is used without copying
+    TsneInputData data = TsneInputData::fromPoints(_inputData, _enabledDimensions);
+
+    // The cache entry is identified by the content of the data and the parameters, not by the data set name
+    if (_saveHierarchyToDisk)
+    {
+        const auto dataHash = HsneCache::hashData(data.data(), data.size());
+        const auto parametersHash = HsneCache::hashString(cacheParametersString(_params, _numPoints, _numDimensions));
+
+        _cacheKey = HsneCache::makeKey(dataHash, parametersHash);
+        _cachePathFileName = _cachePath / _cacheKey;
+    }
+
     // Check of hsne data can be loaded from cache on disk, otherwise compute hsne hierarchy
-    bool hsneLoadedFromCache = loadCache(_params, log);
-    if (hsneLoadedFromCache == false) {
+    bool hsneLoadedFromCache = false;
+    {
+        PhaseProfiler::ScopedPhase phase(&_profiler, LoadCachePhase);
+        hsneLoadedFromCache = loadCache(_params, log);
+    }
+
+    if (_cancellation.isCancelled())
+    {
+        abortInitialization();
+        return;
+    }
+
+    // Scales are only added to a cached hierarchy with the Monte Carlo landmark selection of this plugin:
+    // the HDI object that holds the cached scales was never initialized with the parameters and cannot add scales itself
+    // Extending reads all cached scales, a damaged cache file is recomputed as well
+    if (hsneLoadedFromCache && _numScales < numRequestedScales && (!_params._monte_carlo_sampling || !loadAllScales())) {
+        std::cout << "Recomputing the HSNE hierarchy, the " << _numScales << " cached scales cannot be extended" << std::endl;
+
+        resetLazyCache();
+        _hsne = std::make_unique<Hsne>();
+        _influenceHierarchy.getMap().clear();
+        _numScales = numRequestedScales;
+
+        hsneLoadedFromCache = false;
+    }
+
+    if (hsneLoadedFromCache && _numScales > numRequestedScales) {
+        std::cout << "Using " << numRequestedScales << " of " << _numScales << " cached scales" << std::endl;
+
+        // Drop the cached scales above the requested ones, the cache on disk is left untouched
+        _hsne->hierarchy().resize(numRequestedScales);
+        _influenceHierarchy.getMap().resize(numRequestedScales);
+        _numScales = numRequestedScales;
+
+        _scaleCacheToc.resize(numRequestedScales);
+        _scaleCacheLoaded.resize(numRequestedScales);
+        if (_transitionMatrixCsr.size() > static_cast<size_t>(numRequestedScales))
+            _transitionMatrixCsr.resize(numRequestedScales);
+    }
+    else if (hsneLoadedFromCache && _numScales < numRequestedScales) {
+        std::cout << "Extending cached HSNE hierarchy from " << _numScales << " to " << numRequestedScales << " scales" << std::endl;
+
+        const int firstNewScale = _numScales;
+        const float progressStep = .5f / (numRequestedScales - firstNewScale);
+
+        // Only compute the missing upper scales
+        for (int s = firstNewScale; s < numRequestedScales && !_cancellation.isCancelled(); ++s) {
+            PhaseProfiler::ScopedPhase phase(&_profiler, AddScalePhase);
+            addScale();
+            _parentTask->setProgress((s - firstNewScale + 1) * progressStep, "Adding scales");
+        }
+
+        if (_cancellation.isCancelled())
+        {
+            abortInitialization();
+            return;
+        }
+
+        _numScales = static_cast<int>(_hsne->hierarchy().size());
+
+        _parentTask->setProgress(.5f, "Selection mapping");
+
+        std::cout << "Extending influence hierarchy... " << std::endl;
+        {
+            PhaseProfiler::ScopedPhase phase(&_profiler, InfluenceHierarchyPhase);
+            _influenceHierarchy.extend(*this, firstNewScale);
+        }
+
+        if (_cancellation.isCancelled())
+        {
+            abortInitialization();
+            return;
+        }
+
+        if (_saveHierarchyToDisk)
+        {
+            _parentTask->setProgress(.9f, "Save to disk");
+            PhaseProfiler::ScopedPhase phase(&_profiler, SaveCachePhase);
+            saveCacheHsne(_params);
+        }
+    }
+    else if (hsneLoadedFromCache == false) {
         std::cout << "Initializing HSNE hierarchy" << std::endl;
 
+        // A failed attempt to load the cache may have changed the number of scales
+        _numScales = numRequestedScales;
+
         // Set up a logger
         _hsne->setLogger(&log);
 
@@ -219,37 +471,76 @@ void HsneHierarchy::initialize()
 
         _parentTask->setProgress(.1f, "Data similarities");
 
-        // Load data and enabled dimensions
-        std::vector<float> data;
-        std::vector<unsigned int> dimensionIndices;
-        data.resize((_inputData->isFull() ? _inputData->getNumPoints() : _inputData->indices.size()) * _numDimensions);
-        for (int i = 0; i < _inputData->getNumDimensions(); i++)
-            if (_enabledDimensions[i]) dimensionIndices.push_back(i);
+        // Initialize HSNE with the input data and the given parameters
+        {
+            PhaseProfiler::ScopedPhase phase(&_profiler, DataSimilaritiesPhase);
+
+            const auto knnParameters = getKnnParameters(_params);
 
-        _inputData->populateDataForDimensions<std::vector<float>, std::vector<unsigned int>>(data, dimensionIndices);
+            if (KnnSimilarities::isSupported(knnParameters)) {
+                // The neighbourhood graph of the data scale, queried in batches of points such that a stop takes effect after the current batch.
+                // HDI builds the data scale from these similarities as it does from its own search: num_neighbors + 1 neighbours with a perplexity of a third of them
+                std::cout << "Computing the data scale similarities in batches" << std::endl;
 
-        // Initialize HSNE with the input data and the given parameters
-        _hsne->initialize((Hsne::scalar_type*)data.data(), _numPoints, _params);
+                KnnSimilarities knnSimilarities(knnParameters, _params._num_neighbors + 1, _params._num_neighbors / 3.);
+
+                HsneMatrix similarities;
+                if (knnSimilarities.compute(data.data(), _numPoints, _numDimensions, similarities, _cancellation))
+                    _hsne->initialize(similarities, _params);
+            }
+            else {
+                // HDI cannot be interrupted, a stop requested meanwhile takes effect when it returns
+                std::cout << "Computing the data scale similarities with HDI, a stop takes effect once the nearest neighbour search has finished" << std::endl;
+
+                _hsne->initialize(const_cast<Hsne::scalar_type*>(data.data()), _numPoints, _params);
+            }
+        }
+
+        // Only the data scale needs the high-dimensional data
+        data.release();
+
+        if (_cancellation.isCancelled())
+        {
+            abortInitialization();
+            return;
+        }
 
         _parentTask->setProgress(.33f, "Adding scales");
 
         float progressStep = .33f / _numScales;
 
         // Add a number of scales as indicated by the user
-        for (int s = 0; s < _numScales - 1; ++s) {
-            _hsne->addScale();
+        for (int s = 0; s < _numScales - 1 && !_cancellation.isCancelled(); ++s) {
+            PhaseProfiler::ScopedPhase phase(&_profiler, AddScalePhase);
+            addScale();
             _parentTask->setProgress(.33f + (s + 1) * progressStep, "Adding scales");
         }
 
+        if (_cancellation.isCancelled())
+        {
+            abortInitialization();
+            return;
+        }
+
         _parentTask->setProgress(.66f, "Selection mapping");
 
         std::cout << "Initializing influence hierarchy... " << std::endl;
-        _influenceHierarchy.initialize(*this);
+        {
+            PhaseProfiler::ScopedPhase phase(&_profiler, InfluenceHierarchyPhase);
+            _influenceHierarchy.initialize(*this);
+        }
+
+        if (_cancellation.isCancelled())
+        {
+            abortInitialization();
+            return;
+        }
 
         // Write HSNE hierarchy to disk
         if(_saveHierarchyToDisk)
         {
             _parentTask->setProgress(.9f, "Save to disk");
+            PhaseProfiler::ScopedPhase phase(&_profiler, SaveCachePhase);
             saveCacheHsne(_params);
         }
 
@@ -257,22 +548,675 @@ void HsneHierarchy::initialize()
 
     _isInit = true;
 
+    const auto profile = _profiler.getSummaryTable();
+
+    // Shown with the task, the trace of the phases can be exported from the settings
+    _parentTask->setDescription(QString::fromStdString(profile));
+
+    std::cout << "HSNE phase timings" << std::endl << profile;
+
     emit finished();
     this->moveToThread(QCoreApplication::instance()->thread());
 }
 
+void HsneHierarchy::addScale()
+{
+    // The stationary distribution based landmark selection is left to HDI, only possible on a hierarchy initialized by HDI itself
+    if (!_params._monte_carlo_sampling)
+    {
+        assert(_scaleCacheLoaded.empty());
+
+        _hsne->addScale();
+        return;
+    }
+
+    auto& hierarchy = _hsne->hierarchy();
+    const size_t previousScaleIndex = hierarchy.size() - 1;
+
+    // A lazily loaded top scale needs to be complete before building on top of it
+    ensureScaleLoaded(static_cast<int>(previousScaleIndex));
+
+    hierarchy.emplace_back();
+
+    const auto& previousScale = hierarchy[previousScaleIndex];
+    auto& scale = hierarchy.back();
+
+    const std::uint32_t numPrevious = static_cast<std::uint32_t>(previousScale.size());
+
+    std::cout << "Adding scale " << previousScaleIndex + 1 << " on top of " << numPrevious << " points" << std::endl;
+
+    // Every scale gets its own random streams, derived from the user seed
+    const std::int64_t seed = _params._seed < 0 ? -1 : static_cast<std::int64_t>(_params._seed) + 7919 * static_cast<std::int64_t>(previousScaleIndex + 1);
+    const RandomWalkEngine walks(previousScale._transition_matrix, seed);
+
+    // Landmark selection: points in which many short random walks end
+    auto phaseStart = PhaseProfiler::Clock::now();
+
+    const auto endpointCounts = walks.countWalkEndpoints(_params._mcmcs_num_walks, _params._mcmcs_walk_length, &_cancellation);
+
+    // The incomplete scale is dropped, the caller discards the hierarchy
+    if (_cancellation.isCancelled())
+    {
+        hierarchy.pop_back();
+        return;
+    }
+
+    std::vector<std::uint32_t> landmarks;
+    if (_params._hard_cut_off)
+    {
+        const size_t numLandmarks = std::max<size_t>(1, static_cast<size_t>(numPrevious * _params._hard_cut_off_percentage));
+
+        std::vector<std::uint32_t> order(numPrevious);
+        std::iota(order.begin(), order.end(), 0);
+        std::nth_element(order.begin(), order.begin() + (std::min<size_t>(numLandmarks, numPrevious) - 1), order.end(), [&endpointCounts](std::uint32_t a, std::uint32_t b) {
+            return endpointCounts[a] != endpointCounts[b] ? endpointCounts[a] > endpointCounts[b] : a < b;
+        });
+
+        landmarks.assign(order.begin(), order.begin() + std::min<size_t>(numLandmarks, numPrevious));
+        std::sort(landmarks.begin(), landmarks.end());
+    }
+    else
+    {
+        const double thresh = static_cast<double>(_params._mcmcs_num_walks) * _params._mcmcs_landmark_thresh;
+        for (std::uint32_t i = 0; i < numPrevious; i++)
+            if (endpointCounts[i] > thresh)
+                landmarks.push_back(i);
+    }
+
+    if (landmarks.empty())
+        landmarks.push_back(static_cast<std::uint32_t>(std::max_element(endpointCounts.begin(), endpointCounts.end()) - endpointCounts.begin()));
+
+    const std::uint32_t numLandmarks = static_cast<std::uint32_t>(landmarks.size());
+
+    // Mapping between the landmarks and the previous scale and data level
+    std::vector<std::int32_t> pointToLandmark(numPrevious, -1);
+    scale._landmark_to_previous_scale_idx.resize(numLandmarks);
+    scale._landmark_to_original_data_idx.resize(numLandmarks);
+
+    for (std::uint32_t l = 0; l < numLandmarks; l++)
+    {
+        scale._landmark_to_previous_scale_idx[l] = landmarks[l];
+        scale._landmark_to_original_data_idx[l] = previousScale._landmark_to_original_data_idx[landmarks[l]];
+        pointToLandmark[landmarks[l]] = static_cast<std::int32_t>(l);
+    }
+
+    scale._previous_scale_to_landmark_idx.assign(pointToLandmark.begin(), pointToLandmark.end());
+
+    _profiler.record(LandmarkSelectionPhase, phaseStart, PhaseProfiler::Clock::now());
+
+    // Area of influence: which landmarks are reached first by walks from each previous scale point
+    phaseStart = PhaseProfiler::Clock::now();
+    walks.computeAreaOfInfluence(pointToLandmark, _params._num_walks_per_landmark, _AOI_MAX_WALK_LENGTH_, scale._area_of_influence, &_cancellation);
+    _profiler.record(AreaOfInfluencePhase, phaseStart, PhaseProfiler::Clock::now());
+
+    if (_cancellation.isCancelled())
+    {
+        hierarchy.pop_back();
+        return;
+    }
+
+    phaseStart = PhaseProfiler::Clock::now();
+
+    // Inverse of the area of influence: all previous scale points influenced by a landmark
+    const CsrMatrix influence(scale._area_of_influence);
+    std::vector<std::uint64_t> influencedOffsets(numLandmarks + 1, 0);
+    std::vector<std::uint32_t> influencedPoints(influence.numNonZeros());
+    std::vector<float> influencedValues(influence.numNonZeros());
+
+    for (const auto landmark : influence.getColumns())
+        influencedOffsets[landmark + 1]++;
+    std::partial_sum(influencedOffsets.begin(), influencedOffsets.end(), influencedOffsets.begin());
+
+    {
+        std::vector<std::uint64_t> insertPos(influencedOffsets.begin(), influencedOffsets.end() - 1);
+        for (std::uint32_t point = 0; point < numPrevious; point++)
+        {
+            for (auto pos = influence.rowBegin(point); pos < influence.rowEnd(point); pos++)
+            {
+                const auto landmark = influence.getColumns()[pos];
+                influencedPoints[insertPos[landmark]] = point;
+                influencedValues[insertPos[landmark]] = influence.getValues()[pos];
+                insertPos[landmark]++;
+            }
+        }
+    }
+
+    scale._landmark_weight.resize(numLandmarks);
+    scale._transition_matrix.clear();
+    scale._transition_matrix.resize(numLandmarks);
+
+    // Transition between two landmarks is given by the weighted overlap of their areas of influence
+#pragma omp parallel
+    {
+        std::vector<std::pair<std::uint32_t, float>> overlap;
+
+#pragma omp for schedule(dynamic, 64)
+        for (std::int64_t l = 0; l < static_cast<std::int64_t>(numLandmarks); l++)
+        {
+            if (_cancellation.isCancelled())
+                continue;
+
+            overlap.clear();
+            float weight = 0.f;
+
+            for (auto pos = influencedOffsets[l]; pos < influencedOffsets[l + 1]; pos++)
+            {
+                const auto point = influencedPoints[pos];
+                const float pointInfluence = influencedValues[pos] * previousScale._landmark_weight[point];
+                weight += pointInfluence;
+
+                for (auto posOther = influence.rowBegin(point); posOther < influence.rowEnd(point); posOther++)
+                    overlap.emplace_back(influence.getColumns()[posOther], pointInfluence * influence.getValues()[posOther]);
+            }
+
+            scale._landmark_weight[l] = weight;
+
+            std::sort(overlap.begin(), overlap.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            // Merge duplicate entries in place
+            size_t numMerged = 0;
+            for (size_t i = 0; i < overlap.size(); i++)
+            {
+                if (numMerged > 0 && overlap[numMerged - 1].first == overlap[i].first)
+                    overlap[numMerged - 1].second += overlap[i].second;
+                else
+                    overlap[numMerged++] = overlap[i];
+            }
+            overlap.resize(numMerged);
+
+            float rowSum = 0.f;
+            for (const auto& entry : overlap)
+                rowSum += entry.second;
+
+            if (rowSum <= 0.f)
+                continue;
+
+            // Prune transitions that are expected to be taken by fewer walks than the threshold
+            float prunedSum = 0.f;
+            for (auto& entry : overlap)
+            {
+                if (entry.second / rowSum * _params._num_walks_per_landmark < _params._transition_matrix_prune_thresh)
+                    entry.second = 0.f;
+                prunedSum += entry.second;
+            }
+
+            if (prunedSum <= 0.f)
+                continue;
+
+            auto& row = scale._transition_matrix[l];
+            for (const auto& entry : overlap)
+                if (entry.second > 0.f)
+                    row[entry.first] = entry.second / prunedSum;
+        }
+    }
+
+    _profiler.record(TransitionMatrixPhase, phaseStart, PhaseProfiler::Clock::now());
+
+    if (_cancellation.isCancelled())
+    {
+        hierarchy.pop_back();
+        return;
+    }
+
+    std::cout << "Scale " << previousScaleIndex + 1 << ": " << numLandmarks << " landmarks" << std::endl;
+}
 
 void HsneHierarchy::saveCacheHsne(const Hsne::Parameters& internalParams) const {
     if (!_hsne) return; // only save if initialize() has been called
 
+    if (_cacheKey.empty()) return; // the cache key is set in initialize()
+
     if (!std::filesystem::exists(_cachePath))
-        std::filesystem::create_directory(_cachePath);
+        std::filesystem::create_directories(_cachePath);
 
     std::cout << "HsneHierarchy::saveCacheHsne(): save cache to " + _cachePathFileName.string() << std::endl;
 
-    saveCacheHsneHierarchy(_cachePathFileName.string() + _HIERARCHY_CACHE_EXTENSION_);
-    saveCacheHsneInfluenceHierarchy(_cachePathFileName.string() + _INFLUENCE_TOPDOWN_CACHE_EXTENSION_, _influenceHierarchy.getMap());
+    // Scales that are not paged in yet are read from the file that is about to be overwritten
+    if (!loadAllScales())
+    {
+        std::cerr << "Caching failed. The cached scales could not be read." << std::endl;
+        return;
+    }
+
+    saveCacheScales(_cachePathFileName.string() + _SCALES_CACHE_EXTENSION_);
     saveCacheParameters(_cachePathFileName.string() + _PARAMETERS_CACHE_EXTENSION_, internalParams);
+
+    // Make room for the new entry by removing the least recently used ones
+    HsneCache::enforceSizeLimit(_cachePath, _cacheSizeLimit, _cacheKey);
+}
+
+void HsneHierarchy::saveCacheScales(std::string fileName) const {
+    std::cout << "Writing " + fileName << std::endl;
+
+    std::ofstream saveFile(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!saveFile.is_open())
+    {
+        std::cerr << "Caching failed. File could not be opened. " << std::endl;
+        return;
+    }
+
+    const auto& hierarchy = _hsne->hierarchy();
+    const std::uint32_t numScales = static_cast<std::uint32_t>(hierarchy.size());
+    const std::uint32_t numSections = NumCacheSections;
+
+    saveFile.write(_SCALES_CACHE_MAGIC_, sizeof(_SCALES_CACHE_MAGIC_));
+    saveFile.write((const char*)&_SCALES_CACHE_FORMAT_VERSION_, sizeof(_SCALES_CACHE_FORMAT_VERSION_));
+    saveFile.write((const char*)&numScales, sizeof(numScales));
+    saveFile.write((const char*)&numSections, sizeof(numSections));
+
+    // Reserve the table of contents, it is filled in once all sections are written
+    const auto tocPosition = saveFile.tellp();
+    std::vector<CacheTocEntry> toc(static_cast<size_t>(numScales) * NumCacheSections);
+    saveFile.write((const char*)toc.data(), toc.size() * sizeof(CacheTocEntry));
+
+    const auto& influenceMap = _influenceHierarchy.getMap();
+
+    for (std::uint32_t scale = 0; scale < numScales; scale++)
+    {
+        const auto& scaleData = hierarchy[scale];
+
+        for (std::uint32_t section = 0; section < NumCacheSections; section++)
+        {
+            auto& entry = toc[scale * NumCacheSections + section];
+            entry.offset = static_cast<std::uint64_t>(saveFile.tellp());
+
+            switch (section)
+            {
+            case LandmarksSection:
+                writeVector(saveFile, scaleData._landmark_to_original_data_idx);
+                writeVector(saveFile, scaleData._landmark_to_previous_scale_idx);
+                writeVector(saveFile, scaleData._previous_scale_to_landmark_idx);
+                writeVector(saveFile, scaleData._landmark_weight);
+                break;
+            case TransitionMatrixSection:
+                writeSparseMatrix(saveFile, scaleData._transition_matrix);
+                break;
+            case AreaOfInfluenceSection:
+                writeSparseMatrix(saveFile, scaleData._area_of_influence);
+                break;
+            case LandmarkMapSection:
+            {
+                const std::uint64_t numLandmarks = scale < influenceMap.size() ? influenceMap[scale].size() : 0;
+                saveFile.write((const char*)&numLandmarks, sizeof(numLandmarks));
+                for (std::uint64_t landmark = 0; landmark < numLandmarks; landmark++)
+                    writeVector(saveFile, influenceMap[scale][landmark]);
+                break;
+            }
+            }
+
+            entry.size = static_cast<std::uint64_t>(saveFile.tellp()) - entry.offset;
+        }
+    }
+
+    saveFile.seekp(tocPosition);
+    saveFile.write((const char*)toc.data(), toc.size() * sizeof(CacheTocEntry));
+
+    saveFile.close();
+}
+
+bool HsneHierarchy::loadCacheScaleIndex(std::string fileName, hdi::utils::CoutLog& log) {
+    std::ifstream loadFile(fileName.c_str(), std::ios::in | std::ios::binary);
+
+    if (!loadFile.is_open()) return false;
+
+    std::cout << "Loading table of contents of " + fileName << std::endl;
+
+    char magic[sizeof(_SCALES_CACHE_MAGIC_)] = {};
+    std::uint32_t formatVersion = 0, numScales = 0, numSections = 0;
+
+    loadFile.read(magic, sizeof(magic));
+    loadFile.read((char*)&formatVersion, sizeof(formatVersion));
+    loadFile.read((char*)&numScales, sizeof(numScales));
+    loadFile.read((char*)&numSections, sizeof(numSections));
+
+    if (!loadFile || !std::equal(std::begin(magic), std::end(magic), std::begin(_SCALES_CACHE_MAGIC_)) || formatVersion != _SCALES_CACHE_FORMAT_VERSION_ || numSections != NumCacheSections || numScales == 0)
+    {
+        std::cerr << "Unknown cache file format: " + fileName << std::endl;
+        return false;
+    }
+
+    loadFile.seekg(0, std::ios::end);
+    const std::uint64_t fileSize = static_cast<std::uint64_t>(loadFile.tellg());
+    loadFile.seekg(sizeof(magic) + 3 * sizeof(std::uint32_t));
+
+    if (static_cast<std::uint64_t>(numScales) * NumCacheSections * sizeof(CacheTocEntry) > fileSize)
+    {
+        std::cerr << "Truncated cache file: " + fileName << std::endl;
+        return false;
+    }
+
+    std::vector<CacheTocEntry> toc(static_cast<size_t>(numScales) * NumCacheSections);
+    loadFile.read((char*)toc.data(), toc.size() * sizeof(CacheTocEntry));
+
+    if (!loadFile) return false;
+
+    // All sections need to lie within the file, the sections themselves are checked when they are paged in
+    for (const auto& entry : toc)
+    {
+        if (entry.offset > fileSize || entry.size > fileSize - entry.offset)
+        {
+            std::cerr << "Truncated cache file: " + fileName << std::endl;
+            return false;
+        }
+    }
+
+    resetLazyCache();
+
+    _hsne.reset(new Hsne());
+    _hsne->setLogger(&log);
+    _hsne->hierarchy().resize(numScales);
+
+    _influenceHierarchy.getMap().clear();
+    _influenceHierarchy.getMap().resize(numScales);
+
+    _scaleCacheFile = fileName;
+    _scaleCacheInUse = std::make_unique<HsneCache::InUse>(_cacheKey);
+    _scaleCacheToc.resize(numScales);
+    _scaleCacheLoaded.assign(numScales, {});
+
+    for (std::uint32_t scale = 0; scale < numScales; scale++)
+        for (std::uint32_t section = 0; section < NumCacheSections; section++)
+            _scaleCacheToc[scale][section] = toc[scale * NumCacheSections + section];
+
+    _numScales = static_cast<int>(numScales);
+
+    // The top scale is needed right away for the first embedding, everything else is paged in on demand
+    if (!loadScaleSection(_numScales - 1, LandmarksSection) || !loadScaleSection(_numScales - 1, TransitionMatrixSection))
+    {
+        resetLazyCache();
+        _hsne.reset(new Hsne());
+        _influenceHierarchy.getMap().clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool HsneHierarchy::loadScaleSection(int scale, CacheSection section) const {
+    std::lock_guard<std::mutex> lock(_scaleCacheMutex);
+
+    if (readScaleSection(scale, section))
+        return true;
+
+    // A damaged entry is removed, such that the next initialization recomputes the hierarchy instead of loading it again
+    if (_scaleCacheInUse)
+        HsneCache::remove(_cachePath, _scaleCacheInUse->getKey());
+
+    return false;
+}
+
+bool HsneHierarchy::readScaleSection(int scale, CacheSection section) const {
+    if (scale < 0 || static_cast<size_t>(scale) >= _scaleCacheLoaded.size() || _scaleCacheLoaded[scale][section])
+        return true;
+
+    // The landmarks give the size of the scale, which the other sections are checked against
+    if (section != LandmarksSection && !readScaleSection(scale, LandmarksSection))
+        return false;
+
+    std::ifstream loadFile(_scaleCacheFile, std::ios::in | std::ios::binary);
+
+    if (!loadFile.is_open())
+    {
+        std::cerr << "HsneHierarchy: could not open cache file " + _scaleCacheFile.string() << std::endl;
+        return false;
+    }
+
+    const auto& tocEntry = _scaleCacheToc[scale][section];
+
+    loadFile.seekg(static_cast<std::streamoff>(tocEntry.offset));
+
+    SectionReader reader(loadFile, tocEntry.size);
+
+    auto& scaleData = _hsne->scale(scale);
+    auto& landmarkMap = const_cast<InfluenceHierarchy&>(_influenceHierarchy).getMap()[scale];
+
+    const std::uint64_t numLandmarks = scaleData._landmark_to_original_data_idx.size();
+
+    bool valid = false;
+
+    switch (section)
+    {
+    case LandmarksSection:
+        valid = reader.readVector(scaleData._landmark_to_original_data_idx) &&
+                reader.readVector(scaleData._landmark_to_previous_scale_idx) &&
+                reader.readVector(scaleData._previous_scale_to_landmark_idx) &&
+                reader.readVector(scaleData._landmark_weight) &&
+                scaleData._landmark_weight.size() == scaleData._landmark_to_original_data_idx.size();
+        break;
+    case TransitionMatrixSection:
+        valid = reader.readSparseMatrix(scaleData._transition_matrix, numLandmarks) && scaleData._transition_matrix.size() == numLandmarks;
+        break;
+    case AreaOfInfluenceSection:
+        valid = reader.readSparseMatrix(scaleData._area_of_influence, numLandmarks);
+        break;
+    case LandmarkMapSection:
+    {
+        std::uint64_t numMapped = 0;
+        valid = reader.read(&numMapped, sizeof(numMapped)) && numMapped <= numLandmarks;
+
+        if (valid)
+        {
+            landmarkMap.resize(numMapped);
+            for (std::uint64_t landmark = 0; landmark < numMapped && valid; landmark++)
+                valid = reader.readVector(landmarkMap[landmark]);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    if (!valid || !reader.atEnd())
+    {
+        std::cerr << "HsneHierarchy: section " << section << " of scale " << scale << " in cache file " + _scaleCacheFile.string() + " is damaged" << std::endl;
+
+        // Leave the section empty and not loaded rather than partially filled
+        switch (section)
+        {
+        case LandmarksSection:
+            scaleData._landmark_to_original_data_idx.clear();
+            scaleData._landmark_to_previous_scale_idx.clear();
+            scaleData._previous_scale_to_landmark_idx.clear();
+            scaleData._landmark_weight.clear();
+            break;
+        case TransitionMatrixSection:
+            HsneMatrix().swap(scaleData._transition_matrix);
+            break;
+        case AreaOfInfluenceSection:
+            HsneMatrix().swap(scaleData._area_of_influence);
+            break;
+        case LandmarkMapSection:
+            LandmarkMap().swap(landmarkMap);
+            break;
+        default:
+            break;
+        }
+
+        return false;
+    }
+
+    _scaleCacheLoaded[scale][section] = true;
+
+    return true;
+}
+
+bool HsneHierarchy::ensureScaleLoaded(int scale) const {
+    return loadScaleSection(scale, LandmarksSection) &&
+           loadScaleSection(scale, TransitionMatrixSection) &&
+           loadScaleSection(scale, AreaOfInfluenceSection);
+}
+
+bool HsneHierarchy::loadAllScales() const {
+    for (int scale = 0; scale < static_cast<int>(_scaleCacheLoaded.size()); scale++)
+        for (std::uint32_t section = 0; section < NumCacheSections; section++)
+            if (!loadScaleSection(scale, static_cast<CacheSection>(section)))
+                return false;
+
+    return true;
+}
+
+void HsneHierarchy::resetLazyCache() {
+    {
+        std::lock_guard<std::mutex> lock(_scaleCacheMutex);
+
+        _scaleCacheFile.clear();
+        _scaleCacheInUse.reset();
+        _scaleCacheToc.clear();
+        _scaleCacheLoaded.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(_subGraphMutex);
+    _transitionMatrixCsr.clear();
+}
+
+const CsrMatrix& HsneHierarchy::getTransitionMatrixCsr(int scale) {
+    if (_transitionMatrixCsr.size() <= static_cast<size_t>(scale))
+        _transitionMatrixCsr.resize(scale + 1);
+
+    if (!_transitionMatrixCsr[scale])
+    {
+        loadScaleSection(scale, TransitionMatrixSection);
+        _transitionMatrixCsr[scale] = std::make_unique<CsrMatrix>(_hsne->scale(scale)._transition_matrix);
+    }
+
+    return *_transitionMatrixCsr[scale];
+}
+
+void HsneHierarchy::getTransitionMatrixForSelection(int currentScale, HsneMatrix& transitionMatrix, const std::vector<uint32_t>& landmarkIdxs) {
+    std::lock_guard<std::mutex> lock(_subGraphMutex);
+
+    const CsrMatrix& fullTransitionMatrix = getTransitionMatrixCsr(currentScale - 1);
+    const std::int64_t numSelected = static_cast<std::int64_t>(landmarkIdxs.size());
+
+    // The remap array is allocated once per scale size, only the selected entries are set and reset again below
+    if (_subGraphRemap.size() < fullTransitionMatrix.numRows())
+        _subGraphRemap.resize(fullTransitionMatrix.numRows(), -1);
+
+    for (std::int64_t i = 0; i < numSelected; i++)
+        _subGraphRemap[landmarkIdxs[i]] = static_cast<std::int32_t>(i);
+
+    transitionMatrix.clear();
+    transitionMatrix.resize(numSelected);
+
+    const auto& columns = fullTransitionMatrix.getColumns();
+    const auto& values = fullTransitionMatrix.getValues();
+
+    // Keep the edges between selected landmarks, every row is filtered independently
+#pragma omp parallel
+    {
+        std::vector<std::pair<std::uint32_t, float>> row;
+
+#pragma omp for schedule(dynamic, 256)
+        for (std::int64_t i = 0; i < numSelected; i++)
+        {
+            const auto landmark = landmarkIdxs[i];
+
+            row.clear();
+            for (auto pos = fullTransitionMatrix.rowBegin(landmark); pos < fullTransitionMatrix.rowEnd(landmark); pos++)
+            {
+                const auto newIndex = _subGraphRemap[columns[pos]];
+                if (newIndex >= 0)
+                    row.emplace_back(static_cast<std::uint32_t>(newIndex), values[pos]);
+            }
+
+            // Sorted insertion keeps the MapMemEff rows append-only
+            std::sort(row.begin(), row.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            auto& newRow = transitionMatrix[i];
+            for (const auto& [column, value] : row)
+                newRow[column] = value;
+        }
+    }
+
+    for (std::int64_t i = 0; i < numSelected; i++)
+        _subGraphRemap[landmarkIdxs[i]] = -1;
+}
+
+mv::SelectionMap HsneHierarchy::getSelectionMapping(int scale, const std::vector<uint32_t>& landmarks) const {
+    const LandmarkMap& landmarkMap = getLandmarkMap(scale);
+    const auto& landmarkToOriginalData = getScale(scale)._landmark_to_original_data_idx;
+
+    const bool toGlobal = !_globalIndices.empty();
+    const std::int64_t numLandmarks = static_cast<std::int64_t>(landmarks.size());
+
+    // Every landmark is mapped independently into its own slot
+    std::vector<std::pair<std::uint32_t, std::vector<std::uint32_t>>> entries(numLandmarks);
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for (std::int64_t i = 0; i < numLandmarks; i++)
+    {
+        const auto landmark = landmarks[i];
+        const auto& points = landmarkMap[landmark];
+        auto& [key, mappedPoints] = entries[i];
+
+        key = landmarkToOriginalData[landmark];
+
+        if (toGlobal)
+        {
+            key = _globalIndices[key];
+
+            mappedPoints.resize(points.size());
+            for (size_t j = 0; j < points.size(); j++)
+                mappedPoints[j] = _globalIndices[points[j]];
+        }
+        else
+            mappedPoints.assign(points.begin(), points.end());
+    }
+
+    // Sorted keys make every insertion at the end of the map constant time
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    mv::SelectionMap mapping;
+    auto& selectionMap = mapping.getMap();
+
+    for (auto& [key, mappedPoints] : entries)
+        selectionMap.emplace_hint(selectionMap.end(), key, std::move(mappedPoints));
+
+    return mapping;
+}
+
+std::vector<uint32_t> HsneHierarchy::getInfluencedLandmarksInPreviousScale(int currentScale, const std::vector<uint32_t>& selectedLandmarks, float threshold, size_t* numInfluenced) const {
+    loadScaleSection(currentScale, AreaOfInfluenceSection);
+
+    const auto& scale = _hsne->scale(currentScale);
+    const auto& areaOfInfluence = scale._area_of_influence;
+    const std::int64_t numPreviousLandmarks = static_cast<std::int64_t>(areaOfInfluence.size());
+
+    std::vector<std::uint8_t> isSelected(scale.size(), 0);
+    for (const auto landmark : selectedLandmarks)
+        isSelected[landmark] = 1;
+
+    // Dense scratch array over the previous scale, every row (previous scale landmark) is accumulated independently
+    std::vector<float> influence(numPreviousLandmarks, 0.f);
+
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::int64_t i = 0; i < numPreviousLandmarks; i++)
+    {
+        float sum = 0.f;
+        for (const auto& [landmark, weight] : areaOfInfluence[i])
+            if (isSelected[landmark])
+                sum += weight;
+
+        influence[i] = sum;
+    }
+
+    std::vector<uint32_t> influencedLandmarks;
+    size_t numNonZero = 0;
+
+    for (std::int64_t i = 0; i < numPreviousLandmarks; i++)
+    {
+        if (influence[i] > 0.f)
+            numNonZero++;
+
+        if (influence[i] > threshold)
+            influencedLandmarks.push_back(static_cast<uint32_t>(i));
+    }
+
+    if (numInfluenced)
+        *numInfluenced = numNonZero;
+
+    return influencedLandmarks;
 }
 
 void HsneHierarchy::saveCacheHsneHierarchy(std::string fileName) const {
@@ -340,6 +1284,7 @@ void HsneHierarchy::saveCacheParameters(std::string fileName, const Hsne::Parame
     nlohmann::json parameters;
     parameters["## VERSION ##"] = _PARAMETERS_CACHE_VERSION_;
 
+    parameters["Cache key"] = _cacheKey;
     parameters["Input data name"] = _inputDataName;
     parameters["Number of points"] = _numPoints;
     parameters["Number of dimensions"] = _numDimensions;
@@ -374,16 +1319,15 @@ void HsneHierarchy::saveCacheParameters(std::string fileName, const Hsne::Parame
 
 
 bool HsneHierarchy::loadCache(const Hsne::Parameters& internalParams, hdi::utils::CoutLog& log) {
-    if (!_saveHierarchyToDisk)
+    if (!_saveHierarchyToDisk || _cacheKey.empty())
         return false;
 
     std::cout << "HsneHierarchy::loadCache(): attempt to load cache from " + _cachePathFileName.string() << std::endl;
 
     auto pathParameter = _cachePathFileName.string() + _PARAMETERS_CACHE_EXTENSION_;
-    auto pathHierarchy = _cachePathFileName.string() + _HIERARCHY_CACHE_EXTENSION_;
-    auto pathInfluenceTD = _cachePathFileName.string() + _INFLUENCE_TOPDOWN_CACHE_EXTENSION_;
+    auto pathScales = _cachePathFileName.string() + _SCALES_CACHE_EXTENSION_;
 
-    for (const Path& path : { pathHierarchy, pathInfluenceTD, pathParameter })
+    for (const Path& path : { pathScales, pathParameter })
     {
         if (!(std::filesystem::exists(path)))
         {
@@ -408,8 +1352,12 @@ bool HsneHierarchy::loadCache(const Hsne::Parameters& internalParams, hdi::utils
         }
     };
 
-    _isInit = checkChache(loadCacheHsneHierarchy(pathHierarchy, log), pathHierarchy) &&
-              checkChache(loadCacheHsneInfluenceHierarchy(pathInfluenceTD, _influenceHierarchy.getMap()), pathInfluenceTD);
+    // Only the table of contents and the top scale are read here, lower scales are loaded when they are accessed
+    _isInit = checkChache(loadCacheScaleIndex(pathScales, log), pathScales);
+
+    // Keep recently used entries from being evicted
+    if (_isInit)
+        HsneCache::touch(_cachePath, _cacheKey);
 
     return _isInit;
 }
@@ -426,6 +1374,8 @@ bool HsneHierarchy::loadCacheHsneHierarchy(std::string fileName, hdi::utils::Cou
         _hsne.reset(new Hsne());
     }
 
+    resetLazyCache();
+
     _hsne->setLogger(&log);
 
     hdi::dr::IO::loadHSNE(*_hsne, loadFile, &log);
@@ -509,11 +1459,12 @@ bool HsneHierarchy::checkCacheParameters(const std::string fileName, const Hsne:
         return true;
     };
 
-    if (!checkParam("Input data name", _inputDataName)) return false;
+    // The data name is only informative, the cache key already identifies the data content
+    if (!checkParam("Cache key", _cacheKey)) return false;
     if (!checkParam("Number of points", _numPoints)) return false;
     if (!checkParam("Number of dimensions", _numDimensions)) return false;
 
-    if (!checkParam("Number of Scales", _numScales)) return false;
+    // The number of scales is not checked: missing scales are added on top of the cached ones, surplus scales are dropped
 
     if (!checkParam("Knn library", params._aknn_algorithm)) return false;
     if (!checkParam("Knn distance metric", params._aknn_metric)) return false;
@@ -4,10 +4,17 @@
 #include "hdi/utils/cout_log.h"
 #include "hdi/utils/graph_algorithms.h"
 
+#include "CancellationToken.h"
+#include "CsrMatrix.h"
+#include "HsneCache.h"
+#include "PhaseProfiler.h"
+
 #include "PointData/PointData.h"
 
+#include <array>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -46,6 +53,9 @@ class InfluenceHierarchy : public QObject
 public:
     void initialize(HsneHierarchy& hierarchy);
 
+    /** Compute the landmark maps for the scales starting at firstScale, e.g. after adding scales to a cached hierarchy */
+    void extend(HsneHierarchy& hierarchy, int firstScale);
+
     std::vector<LandmarkMap>& getMap() { return _influenceMap; }
     const std::vector<LandmarkMap>& getMap() const { return _influenceMap; }
 
@@ -70,29 +80,44 @@ public slots:
      */
     void initialize();
 
+    /** Request the initialization to stop, thread-safe. Takes effect at the next cancellation check, afterwards aborted() is emitted */
+    void cancel() { _cancellation.cancel(); }
+
 signals:
     void finished();
 
+    /** The initialization was stopped, the hierarchy is reset to an uninitialized state */
+    void aborted();
+
 public:
     void setDataAndParameters(const mv::Dataset<Points>& inputData, const mv::Dataset<Points>& outputData, const HsneParameters& parameters, const KnnParameters& knnParameters, std::vector<bool>&& enabledDimensions);
 
     // Call before moving this object to another thread
     void initParentTask();
 
-    HsneMatrix getTransitionMatrixAtScale(int scale) { return _hsne->scale(scale)._transition_matrix; }
+    HsneMatrix getTransitionMatrixAtScale(int scale) { loadScaleSection(scale, TransitionMatrixSection); return _hsne->scale(scale)._transition_matrix; }
 
     void printScaleInfo() const;
 
     bool isInitialized() const { return _isInit; }
+    bool isCancelled() const { return _cancellation.isCancelled(); }
 
-    Hsne& getHsne() { return *_hsne.get(); }
-    const Hsne& getHsne() const { return *_hsne.get(); }
+    // Direct access to the HDI hierarchy or the complete influence hierarchy pages in all cached scales
+    Hsne& getHsne() { loadAllScales(); return *_hsne.get(); }
+    const Hsne& getHsne() const { loadAllScales(); return *_hsne.get(); }
 
-    Hsne::scale_type& getScale(int scaleId) { return _hsne->scale(scaleId); }
-    const Hsne::scale_type& getScale(int scaleId) const { return _hsne->scale(scaleId); }
+    Hsne::scale_type& getScale(int scaleId) { ensureScaleLoaded(scaleId); return _hsne->scale(scaleId); }
+    const Hsne::scale_type& getScale(int scaleId) const { ensureScaleLoaded(scaleId); return _hsne->scale(scaleId); }
 
-    InfluenceHierarchy& getInfluenceHierarchy() { return _influenceHierarchy; }
-    const InfluenceHierarchy& getInfluenceHierarchy() const { return _influenceHierarchy; }
+    InfluenceHierarchy& getInfluenceHierarchy() { loadAllScales(); return _influenceHierarchy; }
+    const InfluenceHierarchy& getInfluenceHierarchy() const { loadAllScales(); return _influenceHierarchy; }
+
+    /** Mapping of the landmarks of a scale to the data points they influence most */
+    LandmarkMap& getLandmarkMap(int scaleId) { loadScaleSection(scaleId, LandmarkMapSection); return _influenceHierarchy.getMap()[scaleId]; }
+    const LandmarkMap& getLandmarkMap(int scaleId) const { loadScaleSection(scaleId, LandmarkMapSection); return _influenceHierarchy.getMap()[scaleId]; }
+
+    /** Load all scales that are not yet paged in from the cache, returns false if the cache file is damaged */
+    bool loadAllScales() const;
 
     /**
      * Returns a map of landmark indices and influences on the previous scale in the hierarchy,
@@ -100,27 +125,42 @@ public:
      */
     void getInfluencedLandmarksInPreviousScale(int currentScale, std::vector<unsigned int> indices, std::map<uint32_t, float>& neighbors)
     {
+        loadScaleSection(currentScale, AreaOfInfluenceSection);
         _hsne->getInfluencedLandmarksInPreviousScale(currentScale, indices, neighbors);
     }
 
+    /**
+     * Returns the landmarks of the previous scale (in ascending order) whose influence by the selected landmarks
+     * of the current scale exceeds the threshold. Rows of the area of influence are accumulated in parallel,
+     * selected landmarks are looked up in a dense mask.
+     * @param currentScale Scale of the selected landmarks
+     * @param selectedLandmarks Landmark indices relative to the current scale
+     * @param threshold Minimum accumulated influence of a returned landmark
+     * @param numInfluenced Optional output, number of landmarks in the previous scale with any influence
+     */
+    std::vector<uint32_t> getInfluencedLandmarksInPreviousScale(int currentScale, const std::vector<uint32_t>& selectedLandmarks, float threshold, size_t* numInfluenced = nullptr) const;
+
     void getInfluenceOnDataPoint(unsigned int dataPointId, std::vector<std::unordered_map<unsigned int, float>>& influence, float thresh = 0, bool normalized = true)
     {
         _hsne->getInfluenceOnDataPoint(dataPointId, influence, thresh, normalized);
     }
 
     /**
-     * Extract a subgraph with the selected indexes and the vertices connected to them by an edge with a weight higher then thresh
-     * 
+     * Extract the subgraph of the transition matrix of scale currentScale - 1 between the selected landmarks.
+     * Row and column i of the result correspond to landmarkIdxs[i], the cost is proportional to the edges of the selection
      */
-    void getTransitionMatrixForSelection(int currentScale, HsneMatrix& transitionMatrix, std::vector<uint32_t>& landmarkIdxs)
-    {
-        // Get full transition matrix of the previous scale
-        HsneMatrix& fullTransitionMatrix = _hsne->scale(currentScale-1)._transition_matrix;
+    void getTransitionMatrixForSelection(int currentScale, HsneMatrix& transitionMatrix, const std::vector<uint32_t>& landmarkIdxs);
 
-        // Extract the selected subportion of the transition matrix
-        std::vector<unsigned int> dummy;
-        hdi::utils::extractSubGraph(fullTransitionMatrix, landmarkIdxs, transitionMatrix, dummy, 1);
-    }
+    /**
+     * Linked selection mapping from the given landmarks of a scale to the data points they represent, both in global indices of the input.
+     * Landmarks are mapped in parallel and their point lists are moved into the selection map.
+     * @param scale Scale of the landmarks
+     * @param landmarks Landmark indices relative to the scale
+     */
+    mv::SelectionMap getSelectionMapping(int scale, const std::vector<uint32_t>& landmarks) const;
+
+    /** Global indices of the input points, empty if the input is not a subset. Fetched once per hierarchy */
+    const std::vector<unsigned int>& getGlobalIndices() const { return _globalIndices; }
 
     int getNumScales() const { return _numScales; }
     int getTopScale() const { return _numScales - 1; }
@@ -128,6 +168,9 @@ public:
     int getNumPoints() const { return _numPoints; }
     int getNumDimensions() const { return _numDimensions; }
 
+    /** Timings of the phases of the last initialization, export them while the hierarchy is not being initialized */
+    const PhaseProfiler& getProfiler() const { return _profiler; }
+
     /** Save HSNE hierarchy from this class to disk */
     void saveCacheHsne(const Hsne::Parameters& internalParams) const;
 
@@ -135,6 +178,55 @@ public:
     bool loadCache(const Hsne::Parameters& internalParams, hdi::utils::CoutLog& log);
 
 protected:
+    /** Phases of the initialization profile, in the order of the names given to _profiler */
+    enum ProfilePhase : PhaseProfiler::PhaseId
+    {
+        LoadCachePhase = 0,
+        DataSimilaritiesPhase,
+        AddScalePhase,
+        LandmarkSelectionPhase,
+        AreaOfInfluencePhase,
+        TransitionMatrixPhase,
+        InfluenceHierarchyPhase,
+        SaveCachePhase
+    };
+
+    /** Sections of a scale in the scale-indexed cache file */
+    enum CacheSection : std::uint32_t
+    {
+        LandmarksSection = 0,       /** Landmark index mappings and landmark weights */
+        TransitionMatrixSection,
+        AreaOfInfluenceSection,
+        LandmarkMapSection,         /** Landmark map of the influence hierarchy */
+        NumCacheSections
+    };
+
+    /** Location of a section in the scale-indexed cache file */
+    struct CacheTocEntry
+    {
+        std::uint64_t offset = 0;
+        std::uint64_t size = 0;
+    };
+
+    /** Save all scales and the influence hierarchy to a single, scale-indexed cache file */
+    void saveCacheScales(std::string fileName) const;
+    /** Read the table of contents of a scale-indexed cache file and load the top scale */
+    bool loadCacheScaleIndex(std::string fileName, hdi::utils::CoutLog& log);
+    /**
+     * Page in a section of a scale from the cache file, does nothing if it is already present.
+     * A damaged section is left empty and not loaded, the cache entry is removed and false is returned
+     */
+    bool loadScaleSection(int scale, CacheSection section) const;
+    /** loadScaleSection() without locking, reads the landmarks of the scale first */
+    bool readScaleSection(int scale, CacheSection section) const;
+    /** Page in the landmarks, transition matrix and area of influence of a scale */
+    bool ensureScaleLoaded(int scale) const;
+    /** Forget about the cache file and data derived from the scales, e.g. when the hierarchy is replaced */
+    void resetLazyCache();
+
+    /** CSR copy of the transition matrix of a scale, created on first use and shared by all selections */
+    const CsrMatrix& getTransitionMatrixCsr(int scale);
+
     /** Save HsneHierarchy to disk */
     void saveCacheHsneHierarchy(std::string fileName) const;
     /** Save InfluenceHierarchy to disk */
@@ -151,6 +243,15 @@ protected:
 
     void setIsInitialized(bool init) { _isInit = true; }
 
+    /** Discard a partially computed hierarchy after a stop request, report the abort and hand the object back to the main thread */
+    void abortInitialization();
+
+    /**
+     * Add a scale on top of the current top scale. Landmark selection and the area of influence
+     * are computed with parallel, seeded random walks (see RandomWalkEngine)
+     */
+    void addScale();
+
 private:
     std::unique_ptr<Hsne>   _hsne;
     InfluenceHierarchy      _influenceHierarchy;
@@ -159,7 +260,10 @@ private:
     mv::Dataset<Points>     _inputData;
     mv::Dataset<Points>     _outputData;
     std::string             _inputDataName;
+    std::vector<unsigned int> _globalIndices;                      /** Global indices of the input points if the input is a subset */
     mv::Task*               _parentTask = nullptr;
+    CancellationToken       _cancellation;                         /** Stop request of the initialization, polled per block of the parallel stages */
+    PhaseProfiler           _profiler{ "HSNE hierarchy", { "Load cache", "Data similarities", "Add scale", "Landmark selection", "Area of influence", "Transition matrix", "Influence hierarchy", "Save cache" } };
 
     int                     _numScales = 1;
     unsigned int            _numPoints = 0;
@@ -167,9 +271,21 @@ private:
     Hsne::Parameters        _params;
     bool                    _isInit = false;
 
-    Path                    _cachePath;                            /** Path for saving and loading cache */
-    Path                    _cachePathFileName;                    /** cachePath() + data name */
+    Path                    _cachePath;                            /** Path for saving and loading cache, shared between projects */
+    Path                    _cachePathFileName;                    /** cachePath() + cache key */
+    std::string             _cacheKey;                             /** Hash of the enabled data dimensions and parameters */
+    std::uintmax_t          _cacheSizeLimit = 0;                   /** Maximum size of the cache directory in bytes, 0 is unlimited */
     bool                    _saveHierarchyToDisk = false;
 
+    Path                                                        _scaleCacheFile;        /** Cache file from which scales are paged in */
+    std::unique_ptr<HsneCache::InUse>                           _scaleCacheInUse;       /** Keeps the entry of _scaleCacheFile from being evicted */
+    std::vector<std::array<CacheTocEntry, NumCacheSections>>    _scaleCacheToc;         /** Location of every section of every scale in the cache file */
+    mutable std::vector<std::array<bool, NumCacheSections>>     _scaleCacheLoaded;      /** Whether a section is already loaded, empty if the hierarchy was not loaded from the cache */
+    mutable std::mutex                                          _scaleCacheMutex;       /** Guards paging in sections */
+
+    std::vector<std::unique_ptr<CsrMatrix>>                     _transitionMatrixCsr;   /** Per scale CSR view of the transition matrix */
+    std::vector<std::int32_t>                                   _subGraphRemap;         /** Scale index to selection index, -1 outside of the selection */
+    std::mutex                                                  _subGraphMutex;         /** Guards the CSR views and the remap scratch space */
+
     friend class HsneAnalysisPlugin;
 };
@@ -21,7 +21,8 @@ public:
         _minWalksRequired(0),
         _useOutOfCoreComputation(true),
         _saveHierarchyToDisk(false),
-        _numNeighbors(90)
+        _numNeighbors(90),
+        _cacheSizeLimit(4096)
     {
 
     }
@@ -57,6 +58,9 @@ public:
     void setSaveHierarchyToDisk(bool saveHierarchyToDisk) { _saveHierarchyToDisk = saveHierarchyToDisk; }
     bool getSaveHierarchyToDisk() const { return _saveHierarchyToDisk; }
 
+    void setCacheSizeLimit(int cacheSizeLimit) { _cacheSizeLimit = cacheSizeLimit; }
+    int getCacheSizeLimit() const { return _cacheSizeLimit; }
+
 private:
     // Basic
     
@@ -77,4 +81,5 @@ private:
     // Plugin specific
 
     bool _saveHierarchyToDisk;                      /** Save hierarchy to disk */
+    int _cacheSizeLimit;                            /** Maximum size of the shared hierarchy cache in MB, least recently used hierarchies are removed first. 0 is unlimited */
 };
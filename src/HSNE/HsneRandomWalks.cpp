@@ -0,0 +1,181 @@
+#include "HsneRandomWalks.h"
+
+#include "CancellationToken.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace
+{
+    // Number of start points that are handed to a thread at once
+    constexpr std::int64_t _WALK_BATCH_SIZE_ = 256;
+
+    // SplitMix64 finalizer, used as a stateless counter-based generator
+    inline std::uint64_t mix64(std::uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+}
+
+RandomWalkEngine::RandomWalkEngine(const SparseMatrix& transitionMatrix, std::int64_t seed) :
+    _cumulative(transitionMatrix),
+    _seed(seed < 0 ? static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()) : static_cast<std::uint64_t>(seed))
+{
+    // Turn every row into normalized cumulative probabilities, such that a step is a binary search
+    auto& values = _cumulative.getValues();
+    const std::int64_t numRows = _cumulative.numRows();
+
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (std::int64_t row = 0; row < numRows; row++)
+    {
+        const auto begin = _cumulative.rowBegin(static_cast<std::uint32_t>(row));
+        const auto end = _cumulative.rowEnd(static_cast<std::uint32_t>(row));
+
+        float sum = 0.f;
+        for (auto pos = begin; pos < end; pos++)
+        {
+            sum += values[pos];
+            values[pos] = sum;
+        }
+
+        if (sum <= 0.f)
+            continue;
+
+        for (auto pos = begin; pos < end; pos++)
+            values[pos] /= sum;
+    }
+}
+
+float RandomWalkEngine::uniform(std::uint64_t walk, std::uint64_t counter) const
+{
+    const std::uint64_t bits = mix64(mix64(_seed ^ mix64(walk)) + counter);
+
+    // upper 24 bits give a float in [0, 1)
+    return static_cast<float>(bits >> 40) * (1.0f / 16777216.0f);
+}
+
+std::uint32_t RandomWalkEngine::step(std::uint32_t current, float random) const
+{
+    const auto begin = _cumulative.rowBegin(current);
+    const auto end = _cumulative.rowEnd(current);
+
+    // Points without outgoing transitions absorb the walk
+    if (begin == end)
+        return current;
+
+    const auto& values = _cumulative.getValues();
+    const auto it = std::upper_bound(values.begin() + begin, values.begin() + end, random);
+
+    // Guard against rounding in the last cumulative value
+    const auto pos = (it == values.begin() + end) ? end - 1 : static_cast<std::uint64_t>(it - values.begin());
+
+    return _cumulative.getColumns()[pos];
+}
+
+std::vector<std::uint32_t> RandomWalkEngine::countWalkEndpoints(std::uint32_t numWalksPerPoint, std::uint32_t walkLength, const CancellationToken* cancellation) const
+{
+    const std::int64_t numPoints = _cumulative.numRows();
+    const std::int64_t numBatches = (numPoints + _WALK_BATCH_SIZE_ - 1) / _WALK_BATCH_SIZE_;
+
+    std::vector<std::uint32_t> endpointCounts(numPoints, 0);
+
+#pragma omp parallel for schedule(dynamic, 1)
+    for (std::int64_t batch = 0; batch < numBatches; batch++)
+    {
+        if (cancellation && cancellation->isCancelled())
+            continue;
+
+        const std::int64_t batchEnd = std::min(numPoints, (batch + 1) * _WALK_BATCH_SIZE_);
+
+        for (std::int64_t point = batch * _WALK_BATCH_SIZE_; point < batchEnd; point++)
+        {
+            for (std::uint32_t walk = 0; walk < numWalksPerPoint; walk++)
+            {
+                const std::uint64_t walkId = static_cast<std::uint64_t>(point) * numWalksPerPoint + walk;
+
+                std::uint32_t current = static_cast<std::uint32_t>(point);
+                for (std::uint32_t s = 0; s < walkLength; s++)
+                    current = step(current, uniform(walkId, s));
+
+#pragma omp atomic
+                endpointCounts[current]++;
+            }
+        }
+    }
+
+    return endpointCounts;
+}
+
+void RandomWalkEngine::computeAreaOfInfluence(const std::vector<std::int32_t>& pointToLandmark, std::uint32_t numWalksPerPoint, std::uint32_t maxWalkLength, SparseMatrix& areaOfInfluence, const CancellationToken* cancellation) const
+{
+    const std::int64_t numPoints = _cumulative.numRows();
+    const std::int64_t numBatches = (numPoints + _WALK_BATCH_SIZE_ - 1) / _WALK_BATCH_SIZE_;
+
+    areaOfInfluence.clear();
+    areaOfInfluence.resize(numPoints);
+
+    // Walks of different points are independent from each other, so every batch is processed without synchronization
+#pragma omp parallel for schedule(dynamic, 1)
+    for (std::int64_t batch = 0; batch < numBatches; batch++)
+    {
+        if (cancellation && cancellation->isCancelled())
+            continue;
+
+        const std::int64_t batchEnd = std::min(numPoints, (batch + 1) * _WALK_BATCH_SIZE_);
+
+        std::vector<std::uint32_t> reachedLandmarks;
+        reachedLandmarks.reserve(numWalksPerPoint);
+
+        for (std::int64_t point = batch * _WALK_BATCH_SIZE_; point < batchEnd; point++)
+        {
+            // Landmarks are only influenced by themselves
+            if (pointToLandmark[point] >= 0)
+            {
+                areaOfInfluence[point][static_cast<std::uint32_t>(pointToLandmark[point])] = 1.f;
+                continue;
+            }
+
+            reachedLandmarks.clear();
+
+            for (std::uint32_t walk = 0; walk < numWalksPerPoint; walk++)
+            {
+                const std::uint64_t walkId = static_cast<std::uint64_t>(point) * numWalksPerPoint + walk;
+
+                std::uint32_t current = static_cast<std::uint32_t>(point);
+                for (std::uint32_t s = 0; s < maxWalkLength; s++)
+                {
+                    current = step(current, uniform(walkId, s));
+
+                    if (pointToLandmark[current] >= 0)
+                    {
+                        reachedLandmarks.push_back(static_cast<std::uint32_t>(pointToLandmark[current]));
+                        break;
+                    }
+                }
+            }
+
+            if (reachedLandmarks.empty())
+                continue;
+
+            // Sorted insertion keeps the MapMemEff rows append-only
+            std::sort(reachedLandmarks.begin(), reachedLandmarks.end());
+
+            const float influencePerWalk = 1.f / reachedLandmarks.size();
+            auto& row = areaOfInfluence[point];
+
+            for (size_t i = 0; i < reachedLandmarks.size(); )
+            {
+                size_t j = i;
+                while (j < reachedLandmarks.size() && reachedLandmarks[j] == reachedLandmarks[i])
+                    j++;
+
+                row[reachedLandmarks[i]] = influencePerWalk * (j - i);
+                i = j;
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CsrMatrix.h"
+
+#include "hdi/data/map_mem_eff.h"
+
+#include <cstdint>
+#include <vector>
+
+class CancellationToken;
+
+/**
+ * RandomWalkEngine
+ *
+ * Parallel Monte Carlo random walks over a (row-stochastic) HSNE transition matrix,
+ * used for landmark selection and the area of influence computation when adding scales.
+ *
+ * Walks are processed in batches of start points on all cores. Every walk draws its
+ * random numbers from its own counter-based stream (seed, start point, walk number, step),
+ * so the result only depends on the seed and never on the thread scheduling.
+ * A cancellation token is polled per batch, once cancelled the remaining batches are skipped.
+ */
+class RandomWalkEngine
+{
+public:
+    using SparseMatrix = std::vector<hdi::data::MapMemEff<uint32_t, float>>;
+
+    /**
+     * Constructor
+     * @param transitionMatrix Transition matrix of the scale the walks are performed on
+     * @param seed Seed of the random streams, negative values result in a time based seed
+     */
+    RandomWalkEngine(const SparseMatrix& transitionMatrix, std::int64_t seed);
+
+    /**
+     * Start numWalksPerPoint walks of length walkLength from every point and count how often every point is the end point of a walk
+     * @param cancellation Optional, once cancelled the counts are incomplete
+     * @return Number of walks that ended in each point
+     */
+    std::vector<std::uint32_t> countWalkEndpoints(std::uint32_t numWalksPerPoint, std::uint32_t walkLength, const CancellationToken* cancellation = nullptr) const;
+
+    /**
+     * Start numWalksPerPoint walks from every point, each walk stops at the first landmark it reaches (or after maxWalkLength steps).
+     * Landmarks are fully influenced by themselves. Rows of the area of influence hold the fraction of successful walks that reached each landmark.
+     * @param pointToLandmark For every point the landmark index or -1 if the point is not a landmark
+     * @param numWalksPerPoint Number of walks started from every point
+     * @param maxWalkLength Maximum number of steps of a single walk
+     * @param areaOfInfluence Output, one row per point with (landmark index, influence) entries
+     * @param cancellation Optional, once cancelled the area of influence is incomplete
+     */
+    void computeAreaOfInfluence(const std::vector<std::int32_t>& pointToLandmark, std::uint32_t numWalksPerPoint, std::uint32_t maxWalkLength, SparseMatrix& areaOfInfluence, const CancellationToken* cancellation = nullptr) const;
+
+    std::uint32_t numPoints() const { return _cumulative.numRows(); }
+    std::uint64_t getSeed() const { return _seed; }
+
+private:
+    /** Take a single step from current using a uniform random number in [0, 1) */
+    std::uint32_t step(std::uint32_t current, float random) const;
+
+    /** Uniform random number in [0, 1) of the counter-based stream for walk, at position counter */
+    float uniform(std::uint64_t walk, std::uint64_t counter) const;
+
+private:
+    CsrMatrix       _cumulative;        /** Transition matrix with row-wise normalized, cumulative probabilities */
+    std::uint64_t   _seed;              /** Seed of all random streams */
+};
@@ -9,7 +9,9 @@
 
 #include <PointData/InfoAction.h>
 
+#include <cmath>
 #include <limits>
+#include <random>
 
 #include <QMenu>
 
@@ -20,6 +22,18 @@
 using namespace mv;
 using namespace mv::gui;
 
+// Minimum influence of the selected landmarks on a landmark of the refined scale
+constexpr float _REFINE_INFLUENCE_THRESHOLD_ = 0.5f;
+// Standard deviation of the warm started init embedding, as for other init embeddings
+constexpr float _WARM_START_STDEV_ = 0.0001f;
+// Jitter relative to _WARM_START_STDEV_, separates refined landmarks that are placed at the same position
+constexpr float _WARM_START_JITTER_ = 0.05f;
+// Fractions of the exaggeration and decay iterations that are kept when starting from the parent embedding
+constexpr int _WARM_START_EXAGGERATION_DIVISOR_ = 4;
+constexpr int _WARM_START_DECAY_DIVISOR_ = 2;
+// Scheduling priority of refinements, higher than the default priority of other embeddings
+constexpr int _REFINE_PRIORITY_ = 1;
+
 
 HsneScaleAction::HsneScaleAction(QObject* parent, HsneHierarchy& hsneHierarchy, Dataset<Points> inputDataset, Dataset<Points> embeddingDataset) :
     GroupAction(parent, "HSNE Scale", true),
@@ -219,6 +233,100 @@ void HsneScaleAction::initNonTopScale(const std::vector<uint32_t>& drillIndices)
     _embedding->addAction(*gradDescentAction);
 }
 
+bool HsneScaleAction::computeRefineInitEmbedding(const std::vector<uint32_t>& refinedLandmarks, std::vector<float>& initEmbedding)
+{
+    const auto numEmbeddingPoints = static_cast<std::uint32_t>(_embedding->getNumPoints());
+    const auto numEmbeddingDimensions = static_cast<unsigned int>(_embedding->getNumDimensions());
+    const auto& currentScale = _hsneHierarchy.getScale(_currentScaleLevel);
+
+    if (_tsneParameters.getNumDimensionsOutput() != 2 || numEmbeddingDimensions < 2 || refinedLandmarks.empty())
+        return false;
+
+    if (numEmbeddingPoints != (_isTopScale ? currentScale.size() : _drillIndices.size()))
+        return false;
+
+    // The final positions are the last two dimensions, also when the embedding holds all intermediate steps
+    std::vector<float> positions(2ull * numEmbeddingPoints);
+    _embedding->populateDataForDimensions<std::vector<float>, std::vector<unsigned int>>(positions, { numEmbeddingDimensions - 2, numEmbeddingDimensions - 1 });
+
+    // Scale relative landmark index to its position in the current embedding
+    std::vector<std::int32_t> scaleToLocal(currentScale.size(), -1);
+    for (std::uint32_t i = 0; i < numEmbeddingPoints; i++)
+        scaleToLocal[_isTopScale ? i : _drillIndices[i]] = static_cast<std::int32_t>(i);
+
+    const auto& areaOfInfluence = currentScale._area_of_influence;
+    const std::int64_t numRefined = static_cast<std::int64_t>(refinedLandmarks.size());
+
+    initEmbedding.assign(numRefined * 2, 0.f);
+    std::vector<char> placed(numRefined, 0);
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for (std::int64_t i = 0; i < numRefined; i++)
+    {
+        double x = 0, y = 0, weightSum = 0;
+        for (const auto& [landmark, weight] : areaOfInfluence[refinedLandmarks[i]])
+        {
+            const auto local = scaleToLocal[landmark];
+            if (local < 0)
+                continue;
+
+            x += weight * positions[local * 2];
+            y += weight * positions[local * 2 + 1];
+            weightSum += weight;
+        }
+
+        if (weightSum > 0)
+        {
+            initEmbedding[i * 2] = static_cast<float>(x / weightSum);
+            initEmbedding[i * 2 + 1] = static_cast<float>(y / weightSum);
+            placed[i] = 1;
+        }
+    }
+
+    // Center and rescale the placed landmarks
+    double meanX = 0, meanY = 0;
+    std::int64_t numPlaced = 0;
+    for (std::int64_t i = 0; i < numRefined; i++)
+    {
+        if (!placed[i])
+            continue;
+
+        meanX += initEmbedding[i * 2];
+        meanY += initEmbedding[i * 2 + 1];
+        numPlaced++;
+    }
+
+    if (numPlaced == 0)
+        return false;
+
+    meanX /= numPlaced;
+    meanY /= numPlaced;
+
+    double variance = 0;
+    for (std::int64_t i = 0; i < numRefined; i++)
+        if (placed[i])
+            variance += std::pow(initEmbedding[i * 2] - meanX, 2) + std::pow(initEmbedding[i * 2 + 1] - meanY, 2);
+
+    const double stdev = std::sqrt(variance / (2.0 * numPlaced));
+    const float scaleFactor = stdev > 0 ? static_cast<float>(_WARM_START_STDEV_ / stdev) : 0.f;
+
+    // Seeded jitter, refinements of the same selection start identically
+    std::mt19937 gen(static_cast<std::uint32_t>(numRefined * 31 + _currentScaleLevel));
+    std::normal_distribution<float> jitter(0.f, _WARM_START_STDEV_ * _WARM_START_JITTER_);
+
+    for (std::int64_t i = 0; i < numRefined; i++)
+    {
+        // Landmarks without influence on the current embedding start at the center
+        const float x = placed[i] ? static_cast<float>(initEmbedding[i * 2] - meanX) * scaleFactor : 0.f;
+        const float y = placed[i] ? static_cast<float>(initEmbedding[i * 2 + 1] - meanY) * scaleFactor : 0.f;
+
+        initEmbedding[i * 2] = x + jitter(gen);
+        initEmbedding[i * 2 + 1] = y + jitter(gen);
+    }
+
+    return true;
+}
+
 void HsneScaleAction::refine()
 {
     _initializationTask.setRunning();
@@ -244,21 +352,13 @@ void HsneScaleAction::refine()
         }
     }
     
-    // Find the points in the previous level corresponding to selected landmarks
-    std::map<uint32_t, float> neighbors;
-    _hsneHierarchy.getInfluencedLandmarksInPreviousScale(_currentScaleLevel, selectedLandmarks, neighbors);
-
-    // Threshold neighbours with enough influence, these represent the indices of the refined points relative to their HSNE scale
-    std::vector<uint32_t> refinedLandmarks; // Scale-relative indices
-    refinedLandmarks.clear();
-    for (const auto& n : neighbors) {
-        if (n.second > 0.5) //QUICKPAPER
-        {
-            refinedLandmarks.push_back(n.first);
-        }
-    }
+    // Find the points in the previous level corresponding to selected landmarks and keep those with enough influence,
+    // these represent the indices of the refined points relative to their HSNE scale
+    size_t numInfluenced = 0;
+    std::vector<uint32_t> refinedLandmarks = _hsneHierarchy.getInfluencedLandmarksInPreviousScale(_currentScaleLevel, selectedLandmarks, _REFINE_INFLUENCE_THRESHOLD_, &numInfluenced); // Scale-relative indices
+
     std::cout << "#selected landmarks: " << selectedLandmarks.size() << std::endl;
-    std::cout << "#landmarks at refined scale: " << neighbors.size() << std::endl;
+    std::cout << "#landmarks at refined scale: " << numInfluenced << std::endl;
     std::cout << "#thresholded landmarks at refined scale: " << refinedLandmarks.size() << std::endl;
     std::cout << "Refining embedding.." << std::endl;
     
@@ -285,8 +385,7 @@ void HsneScaleAction::refine()
         }
         else
         {
-            std::vector<unsigned int> globalIndices;
-            _input->getGlobalIndices(globalIndices);
+            const auto& globalIndices = _hsneHierarchy.getGlobalIndices();
             for (int i = 0; i < refinedLandmarks.size(); i++)
                 selection->indices.push_back(globalIndices[refinedScale._landmark_to_original_data_idx[refinedLandmarks[i]]]);
         }
@@ -318,8 +417,6 @@ void HsneScaleAction::refine()
         datasetTask.setName("HSNE scale computation");
         datasetTask.setConfigurationFlag(Task::ConfigurationFlag::OverrideAggregateStatus);
 
-        _tsneAnalysis.setTask(&datasetTask);
-
         // Insert HsneScaleAction into new data set
         _refinedScaledActions.push_back(new HsneScaleAction(this, _hsneHierarchy, _input, refineEmbedding, refinedScaleLevel));
         auto& _refinedScaledAction = _refinedScaledActions.back();
@@ -335,49 +432,24 @@ void HsneScaleAction::refine()
     // Add linked selection between the refined embedding and the bottom level points
     if (refinedScaleLevel > 0) // Only add a linked selection if it's not the bottom level already
     {
-        LandmarkMap& landmarkMap = _hsneHierarchy.getInfluenceHierarchy().getMap()[refinedScaleLevel];
-
-        mv::SelectionMap mapping;
-        auto& selectionMap = mapping.getMap();
-
-        if (_input->isFull())
-        {
-            for (const unsigned int& scaleIndex : refinedLandmarks)
-            {
-                int bottomLevelIdx = _hsneHierarchy.getScale(refinedScaleLevel)._landmark_to_original_data_idx[scaleIndex];
-                selectionMap[bottomLevelIdx] = landmarkMap[scaleIndex];
-            }
-        }
-        else
-        {
-            // Link drill-in points to bottom level indices when the original input to HSNE was a subset
-            std::vector<unsigned int> globalIndices;
-            _input->getGlobalIndices(globalIndices);
-            for (const unsigned int& scaleIndex : refinedLandmarks)
-            {
-                std::vector<unsigned int> bottomMap = landmarkMap[scaleIndex];
-                // Transform bottom level indices to the global full set indices
-                for (int j = 0; j < bottomMap.size(); j++)
-                {
-                    bottomMap[j] = globalIndices[bottomMap[j]];
-                }
-                int bottomLevelIdx = _hsneHierarchy.getScale(refinedScaleLevel)._landmark_to_original_data_idx[scaleIndex];
-                selectionMap[globalIndices[bottomLevelIdx]] = bottomMap;
-            }
-        }
+        // Drill-in points are linked to bottom level indices, in global indices when the original input to HSNE was a subset
+        mv::SelectionMap mapping = _hsneHierarchy.getSelectionMapping(refinedScaleLevel, refinedLandmarks);
 
         _refineEmbeddings.back()->addLinkedData(_input, mapping);
     }
 
-    // Update embedding points when the TSNE analysis produces new data
-    connect(&_tsneAnalysis, &TsneAnalysis::embeddingUpdate, this, [this, refinedScaleLevel](const TsneData& tsneData) {
+    // The refined scale action owns the analysis of its embedding, such that several refinements of this scale can run side by side
+    auto refineEmbedding = _refineEmbeddings.back();
+    auto refinedScaleAction = _refinedScaledActions.back();
+    auto& refineAnalysis = refinedScaleAction->_tsneAnalysis;
 
-        auto& refineEmbedding = _refineEmbeddings.back();
+    // Update embedding points when the TSNE analysis produces new data
+    connect(&refineAnalysis, &TsneAnalysis::embeddingUpdate, refinedScaleAction, [refineEmbedding, refinedScaleAction, &refineAnalysis](const TsneData& tsneData) {
 
         // Update the refine embedding with new data
         refineEmbedding->setData(tsneData.getData().data(), tsneData.getNumPoints(), 2);
 
-        _refinedScaledActions.back()->getNumberOfComputatedIterationsAction().setValue(_tsneAnalysis.getNumIterations() - 1);
+        refinedScaleAction->getNumberOfComputatedIterationsAction().setValue(refineAnalysis.getNumIterations() - 1);
 
         // Notify others that the embedding points have changed
         events().notifyDatasetDataChanged(refineEmbedding);
@@ -386,10 +458,10 @@ void HsneScaleAction::refine()
     // Handle tasks
     _initializationTask.setFinished();
 
-    auto& datasetTask = _refineEmbeddings.back()->getTask();
+    auto& datasetTask = refineEmbedding->getTask();
     datasetTask.setName("Embed HSNE scale");
     datasetTask.setConfigurationFlag(Task::ConfigurationFlag::OverrideAggregateStatus);
-    _tsneAnalysis.setTask(&datasetTask);
+    refineAnalysis.setTask(&datasetTask);
     datasetTask.setRunning();
 
     // Get gradient descent settings from top level if applicable
@@ -400,8 +472,22 @@ void HsneScaleAction::refine()
         _tsneParameters.setExponentialDecayIter(_tsneParametersTopLevel->getExponentialDecayIter());
     }
 
-    // Start the embedding process
-    _tsneAnalysis.startComputation(_tsneParameters, refinedTransitionMatrix, refinedLandmarks.size());
+    // Warm start from the current embedding: the coarse layout is already there, so a short exaggeration phase suffices
+    TsneParameters refineParameters = _tsneParameters;
+    std::vector<float> initEmbedding;
+    const bool warmStart = computeRefineInitEmbedding(refinedLandmarks, initEmbedding);
+
+    if (warmStart)
+    {
+        refineParameters.setExaggerationIter(_tsneParameters.getExaggerationIter() / _WARM_START_EXAGGERATION_DIVISOR_);
+        refineParameters.setExponentialDecayIter(_tsneParameters.getExponentialDecayIter() / _WARM_START_DECAY_DIVISOR_);
+    }
+
+    std::cout << "Refined embedding " << (warmStart ? "starts from the current embedding" : "starts from a random layout") << std::endl;
+
+    // Start the embedding process, drill-ins are interactive and overtake queued full embeddings
+    refineAnalysis.setPriority(_REFINE_PRIORITY_);
+    refineAnalysis.startComputation(refineParameters, refinedTransitionMatrix, refinedLandmarks.size(), warmStart ? &initEmbedding : nullptr);
 }
 
 void HsneScaleAction::fromVariantMap(const QVariantMap& variantMap)
@@ -62,6 +62,14 @@ private:
     /** Refine the landmarks based on the current selection */
     void refine();
 
+    /**
+     * Place the refined landmarks at the influence-weighted average position of the landmarks of this scale in the current embedding
+     * @param refinedLandmarks Indices of the refined landmarks relative to the refined scale
+     * @param initEmbedding Output, 2D init embedding of the refined landmarks
+     * @return Whether the init embedding could be derived from the current embedding
+     */
+    bool computeRefineInitEmbedding(const std::vector<uint32_t>& refinedLandmarks, std::vector<float>& initEmbedding);
+
     /** Add actions to GUI and connect them */
     void initLayoutAndConnection();
 
@@ -66,6 +66,9 @@ void HsneSettingsAction::fromVariantMap(const QVariantMap& variantMap)
     _hsneParameters.useOutOfCoreComputation(variantMap["OutOfCoreComputation"].toBool());
     _hsneParameters.setSaveHierarchyToDisk(variantMap["SaveHierarchyToDisk"].toBool());
 
+    if (variantMap.contains("CacheSizeLimit"))
+        _hsneParameters.setCacheSizeLimit(variantMap["CacheSizeLimit"].toInt());
+
     _tsneParameters.setNumIterations(variantMap["NumIterations"].toInt());
     _tsneParameters.setExaggerationIter(variantMap["ExaggerationIter"].toInt());
     _tsneParameters.setExponentialDecayIter(variantMap["ExponentialDecayIter"].toInt());
@@ -101,6 +104,7 @@ QVariantMap HsneSettingsAction::toVariantMap() const
     variantMap.insert({ { "MonteCarloSampling", QVariant::fromValue(_hsneParameters.useMonteCarloSampling()) } });
     variantMap.insert({ { "OutOfCoreComputation", QVariant::fromValue(_hsneParameters.useOutOfCoreComputation()) } });
     variantMap.insert({ { "SaveHierarchyToDisk", QVariant::fromValue(_hsneParameters.getSaveHierarchyToDisk()) } });
+    variantMap.insert({ { "CacheSizeLimit", QVariant::fromValue(_hsneParameters.getCacheSizeLimit()) } });
 
     variantMap.insert({ { "NumIterations", QVariant::fromValue(_tsneParameters.getNumIterations()) } });
     variantMap.insert({ { "ExaggerationIter", QVariant::fromValue(_tsneParameters.getExaggerationIter()) } });
@@ -11,35 +11,57 @@ GeneralTsneSettingsAction::GeneralTsneSettingsAction(TsneSettingsAction& tsneSet
     _distanceMetricAction(this, "Distance metric"),
     _perplexityAction(this, "Perplexity"),
     _subsampleAction(this, "Save embeddings"),
+    _trajectoryStatisticsAction(this, "Trajectory statistics", false),
+    _alignSnapshotsAction(this, "Align saved embeddings", false),
+    _memoryBudgetAction(this, "Memory budget [MB]"),
+    _memoryPolicyAction(this, "Memory policy"),
     _computationAction(this),
     _reinitAction(this, "Reintialize instead of recompute", false),
-    _saveProbDistAction(this, "Save analysis to projects", false)
+    _saveProbDistAction(this, "Save analysis to projects", false),
+    _exportProfileAction(this, "Export profile")
 {
     addAction(&_knnAlgorithmAction);
     addAction(&_numDimensionAction);
     addAction(&_distanceMetricAction);
     addAction(&_perplexityAction);
     addAction(&_subsampleAction);
+    addAction(&_trajectoryStatisticsAction);
+    addAction(&_alignSnapshotsAction);
+    addAction(&_memoryBudgetAction);
+    addAction(&_memoryPolicyAction);
     
     _computationAction.addActions();
 
     addAction(&_reinitAction);
     addAction(&_saveProbDistAction);
+    addAction(&_exportProfileAction);
 
     _knnAlgorithmAction.setDefaultWidgetFlags(OptionAction::ComboBox);
     _numDimensionAction.setDefaultWidgetFlags(OptionAction::ComboBox);
     _distanceMetricAction.setDefaultWidgetFlags(OptionAction::ComboBox);
     _subsampleAction.setDefaultWidgetFlags(OptionAction::ComboBox);
     _perplexityAction.setDefaultWidgetFlags(IntegralAction::SpinBox | IntegralAction::Slider);
+    _memoryBudgetAction.setDefaultWidgetFlags(IntegralAction::SpinBox);
 
     _knnAlgorithmAction.initialize(QStringList({ "FLANN", "HNSW", "ANNOY" }), "FLANN");
     _numDimensionAction.initialize(QStringList({ "1", "2" }), "2");
     _distanceMetricAction.initialize(QStringList({ "Euclidean", "Cosine", "Inner Product", "Manhattan", "Hamming", "Dot" }), "Euclidean");
-    _subsampleAction.initialize(QStringList({ "Every Iter", "Every 5 Iters", "Every 10 Iters" }), "Every 10 Iters");
+    _subsampleAction.initialize(QStringList({ "Every Iter", "Every 5 Iters", "Every 10 Iters", "Statistics only" }), "Every 10 Iters");
     _perplexityAction.initialize(2, 50, 30);
+    _memoryBudgetAction.initialize(0, 1048576, 4096);
 
+    // Only reports the policy of the last computation
+    _memoryPolicyAction.setEnabled(false);
+
+    _knnAlgorithmAction.setToolTip("Library of the nearest neighbour search of the similarities.\nOnly FLANN with the Euclidean metric can be stopped while the neighbours are searched,\nwith HNSW and ANNOY a stop takes effect once the search has finished.");
     _reinitAction.setToolTip("Instead of recomputing knn, simply re-initialize t-SNE embedding and recompute gradient descent.");
     _saveProbDistAction.setToolTip("When saving the t-SNE analysis with your project, you can compute additional iterations without recomputing similarities from scratch.");
+    _subsampleAction.setToolTip("Iterations of which the embedding is kept for the output trajectories.\n'Statistics only' keeps no intermediate embeddings and publishes the trajectory statistics instead.");
+    _trajectoryStatisticsAction.setToolTip("Publish per-point path length, mean velocity, stabilization iteration and maximal displacement as an additional data set.");
+    _exportProfileAction.setToolTip("Save the timings of the phases of the last computation as Chrome trace JSON, open it in Perfetto or chrome://tracing.");
+    _alignSnapshotsAction.setToolTip("Rotate and translate every saved 2D embedding onto the previous one, such that the trajectories show the local dynamics instead of the global drift.");
+    _memoryBudgetAction.setToolTip("Memory available for the saved embeddings, 0 for no limit.\nIf the embeddings do not fit, they are stored in half precision, fewer iterations are saved or only the statistics are kept.");
+    _memoryPolicyAction.setToolTip("Estimated memory of the saved embeddings of the last computation and how they were adapted to the memory budget");
 
     const auto updateKnnAlgorithm = [this]() -> void {
         if (_knnAlgorithmAction.getCurrentText() == "FLANN")
@@ -89,8 +111,22 @@ GeneralTsneSettingsAction::GeneralTsneSettingsAction(TsneSettingsAction& tsneSet
 
         if (_subsampleAction.getCurrentText() == "Every 10 Iters")
             _tsneSettingsAction.getTsneParameters().setSubsampleFactor(10);
+
+        _tsneSettingsAction.getTsneParameters().setRecordTrajectory(_subsampleAction.getCurrentText() != "Statistics only");
         };
 
+    const auto updateTrajectoryStatistics = [this]() -> void {
+        _tsneSettingsAction.getTsneParameters().setTrajectoryStatistics(_trajectoryStatisticsAction.isChecked());
+    };
+
+    const auto updateAlignSnapshots = [this]() -> void {
+        _tsneSettingsAction.getTsneParameters().setAlignSnapshots(_alignSnapshotsAction.isChecked());
+    };
+
+    const auto updateMemoryBudget = [this]() -> void {
+        _tsneSettingsAction.getTsneParameters().setTrajectoryMemoryBudget(_memoryBudgetAction.getValue());
+    };
+
     const auto updateNumIterations = [this]() -> void {
         _tsneSettingsAction.getTsneParameters().setNumIterations(_computationAction.getNumIterationsAction().getValue());
     };
@@ -135,6 +171,10 @@ GeneralTsneSettingsAction::GeneralTsneSettingsAction(TsneSettingsAction& tsneSet
         _reinitAction.setEnabled(enable);
         _saveProbDistAction.setEnabled(enable);
         _subsampleAction.setEnabled(enable);
+        _trajectoryStatisticsAction.setEnabled(enable);
+        _alignSnapshotsAction.setEnabled(enable);
+        _memoryBudgetAction.setEnabled(enable);
+        _exportProfileAction.setEnabled(enable);
     };
 
     connect(&_knnAlgorithmAction, &OptionAction::currentIndexChanged, this, [this, updateKnnAlgorithm](const std::int32_t& currentIndex) {
@@ -161,6 +201,18 @@ GeneralTsneSettingsAction::GeneralTsneSettingsAction(TsneSettingsAction& tsneSet
         updateSubsample();
     });
 
+    connect(&_trajectoryStatisticsAction, &ToggleAction::toggled, this, [this, updateTrajectoryStatistics](const bool toggled) {
+        updateTrajectoryStatistics();
+    });
+
+    connect(&_alignSnapshotsAction, &ToggleAction::toggled, this, [this, updateAlignSnapshots](const bool toggled) {
+        updateAlignSnapshots();
+    });
+
+    connect(&_memoryBudgetAction, &IntegralAction::valueChanged, this, [this, updateMemoryBudget](const std::int32_t& value) {
+        updateMemoryBudget();
+    });
+
     connect(&_computationAction.getUpdateIterationsAction(), &IntegralAction::valueChanged, this, [this, updateCoreUpdate](const std::int32_t& value) {
         updateCoreUpdate();
     });
@@ -179,6 +231,9 @@ GeneralTsneSettingsAction::GeneralTsneSettingsAction(TsneSettingsAction& tsneSet
     updateNumIterations();
     updatePerplexity();
     updateCoreUpdate();
+    updateTrajectoryStatistics();
+    updateAlignSnapshots();
+    updateMemoryBudget();
     updateReadOnly();
 
     _reinitAction.setEnabled(false);    // only enable after first compute
@@ -196,6 +251,15 @@ void GeneralTsneSettingsAction::fromVariantMap(const QVariantMap& variantMap)
     _computationAction.fromParentVariantMap(variantMap);
     _reinitAction.fromParentVariantMap(variantMap);
     _saveProbDistAction.fromParentVariantMap(variantMap);
+
+    if (variantMap.contains(_trajectoryStatisticsAction.getSerializationName()))
+        _trajectoryStatisticsAction.fromParentVariantMap(variantMap);
+
+    if (variantMap.contains(_alignSnapshotsAction.getSerializationName()))
+        _alignSnapshotsAction.fromParentVariantMap(variantMap);
+
+    if (variantMap.contains(_memoryBudgetAction.getSerializationName()))
+        _memoryBudgetAction.fromParentVariantMap(variantMap);
 }
 
 QVariantMap GeneralTsneSettingsAction::toVariantMap() const
@@ -209,6 +273,9 @@ QVariantMap GeneralTsneSettingsAction::toVariantMap() const
     _computationAction.insertIntoVariantMap(variantMap);
     _reinitAction.insertIntoVariantMap(variantMap);
     _saveProbDistAction.insertIntoVariantMap(variantMap);
+    _trajectoryStatisticsAction.insertIntoVariantMap(variantMap);
+    _alignSnapshotsAction.insertIntoVariantMap(variantMap);
+    _memoryBudgetAction.insertIntoVariantMap(variantMap);
 
     return variantMap;
 }
@@ -2,7 +2,9 @@
 
 #include "actions/IntegralAction.h"
 #include "actions/OptionAction.h"
+#include "actions/StringAction.h"
 #include "actions/ToggleAction.h"
+#include "actions/TriggerAction.h"
 
 #include "TsneComputationAction.h"
 
@@ -37,9 +39,14 @@ public: // Action getters
     IntegralAction& getNumberOfComputatedIterationsAction() { return _computationAction.getNumberOfComputatedIterationsAction(); };
     IntegralAction& getPerplexityAction() { return _perplexityAction; };
     OptionAction& getSubsampleAction() { return _subsampleAction; };
+    ToggleAction& getTrajectoryStatisticsAction() { return _trajectoryStatisticsAction; };
+    ToggleAction& getAlignSnapshotsAction() { return _alignSnapshotsAction; };
+    IntegralAction& getMemoryBudgetAction() { return _memoryBudgetAction; };
+    StringAction& getMemoryPolicyAction() { return _memoryPolicyAction; };
     TsneComputationAction& getComputationAction() { return _computationAction; }
     ToggleAction& getReinitAction() { return _reinitAction; }
     ToggleAction& getSaveProbDistAction() { return _saveProbDistAction; }
+    TriggerAction& getExportProfileAction() { return _exportProfileAction; }
 
 public: // Serialization
 
@@ -62,7 +69,12 @@ protected:
     OptionAction            _distanceMetricAction;                  /** Distance metric action */
     IntegralAction          _perplexityAction;                      /** Perplexity action */
     OptionAction            _subsampleAction;                       /** Subsample action */
+    ToggleAction            _trajectoryStatisticsAction;            /** Whether to publish per-point trajectory statistics */
+    ToggleAction            _alignSnapshotsAction;                  /** Whether to remove the rigid motion between saved embeddings */
+    IntegralAction          _memoryBudgetAction;                    /** Memory ceiling of the saved embeddings in MB */
+    StringAction            _memoryPolicyAction;                    /** Memory estimate of the saved embeddings and the applied adaptation */
     TsneComputationAction   _computationAction;                     /** Computation action */
     ToggleAction            _reinitAction;                          /** Whether to re-initialize instead of recomputing from scratch */
     ToggleAction            _saveProbDistAction;                    /** Save t-SNE to projects action */
+    TriggerAction           _exportProfileAction;                   /** Export the phase timings of the last computation as a trace */
 };
@@ -28,8 +28,10 @@ InitTsneSettings::InitTsneSettings(TsneSettingsAction& tsneSettingsAction, size_
     _dataDimensionActionX(this, "Init dim X"),
     _dataDimensionActionY(this, "Init dim Y"),
     _rescaleInitAction(this, "Rescale to small std dev", true),
+    _pcaInitAction(this, "PCA initial embedding", false),
     _numPointsInputData(numPointsInputData)
 {
+    addAction(&_pcaInitAction);
     addAction(&_randomInitAction);
     addAction(&_randomSeedAction);
     addAction(&_newRandomSeedAction);
@@ -44,6 +46,7 @@ InitTsneSettings::InitTsneSettings(TsneSettingsAction& tsneSettingsAction, size_
     _datasetInitAction.setToolTip("Dataset to use for init.");
     _dataDimensionActionX.setToolTip("Dimensions of dataset to use for inititial embedding X dimension.");
     _dataDimensionActionY.setToolTip("Dimensions of dataset to use for inititial embedding Y dimension.");
+    _pcaInitAction.setToolTip("Init t-SNE with the first principal components of the input data, \ncomputed with a randomized SVD while the similarities are computed.");
     _rescaleInitAction.setToolTip("Whether to rescale the init embedding such that the standard deviation of \nthe first embedding dimension is 0.0001.");
 
     _datasetInitAction.setEnabled(false);
@@ -88,9 +91,30 @@ InitTsneSettings::InitTsneSettings(TsneSettingsAction& tsneSettingsAction, size_
         _dataDimensionActionY.setEnabled(!checked);
     });
 
+    connect(&_pcaInitAction, &ToggleAction::toggled, this, [this](bool toggled) {
+        _tsneSettingsAction.getTsneParameters().setPcaInitialization(toggled);
+
+        // The PCA init replaces the random or data set init
+        const auto enable = !toggled && !isReadOnly();
+
+        _randomInitAction.setEnabled(enable);
+        _randomSeedAction.setEnabled(enable && _randomInitAction.isChecked());
+        _newRandomSeedAction.setEnabled(enable && _randomInitAction.isChecked());
+        _rescaleInitAction.setEnabled(enable);
+
+        _datasetInitAction.setEnabled(enable && !_randomInitAction.isChecked());
+        _dataDimensionActionX.setEnabled(enable && !_randomInitAction.isChecked());
+        _dataDimensionActionY.setEnabled(enable && !_randomInitAction.isChecked());
+    });
+
     const auto updateReadOnly = [this]() -> void {
         auto enable = !isReadOnly();
 
+        _pcaInitAction.setEnabled(enable);
+
+        if (_pcaInitAction.isChecked())
+            enable = false;
+
         _randomInitAction.setEnabled(enable);
         _randomSeedAction.setEnabled(enable);
         _newRandomSeedAction.setEnabled(enable);
@@ -117,16 +141,24 @@ void InitTsneSettings::updateDatasetPicker()
 }
 
 std::vector<float> InitTsneSettings::getInitEmbedding(size_t numPoints, int numDimensions)
+{
+    return getInitEmbedding(numPoints, numDimensions, _randomSeedAction.getValue());
+}
+
+std::vector<float> InitTsneSettings::getInitEmbedding(size_t numPoints, int numDimensions, int seed)
 {
     assert(numPoints > 0);
     qDebug() << "Initializing t-SNE embedding with " << numPoints << " points and " << numDimensions << " dimensions";
     std::vector<float> initPositions(numPoints * numDimensions, -1.f);
 
-    if (_randomInitAction.isChecked())
+    if (_pcaInitAction.isChecked())
+        qDebug() << "The t-SNE worker computes a PCA initialization, this embedding is only used if that is not possible";
+
+    if (_randomInitAction.isChecked() || _pcaInitAction.isChecked())
     {
         qDebug() << "Initialize t-SNE embedding randomly";
 
-        std::default_random_engine gen(_randomSeedAction.getValue());
+        std::default_random_engine gen(seed);
         std::uniform_real_distribution<float> dis(0, 1);
 
         auto randomVec = [&gen, &dis]() -> std::pair<float, float> {
@@ -223,6 +255,9 @@ void InitTsneSettings::fromVariantMap(const QVariantMap& variantMap)
     _dataDimensionActionX.fromParentVariantMap(variantMap);
     _dataDimensionActionY.fromParentVariantMap(variantMap);
     _rescaleInitAction.fromParentVariantMap(variantMap);
+
+    if (variantMap.contains(_pcaInitAction.getSerializationName()))
+        _pcaInitAction.fromParentVariantMap(variantMap);
 }
 
 QVariantMap InitTsneSettings::toVariantMap() const
@@ -236,6 +271,7 @@ QVariantMap InitTsneSettings::toVariantMap() const
     _dataDimensionActionX.insertIntoVariantMap(variantMap);
     _dataDimensionActionY.insertIntoVariantMap(variantMap);
     _rescaleInitAction.insertIntoVariantMap(variantMap);
+    _pcaInitAction.insertIntoVariantMap(variantMap);
 
     return variantMap;
 }
@@ -30,6 +30,9 @@ public:
 
     std::vector<float> getInitEmbedding(size_t numPoints, int numDimensions);
 
+    /** Same as above, but a random initialization uses the given seed instead of the seed setting */
+    std::vector<float> getInitEmbedding(size_t numPoints, int numDimensions, int seed);
+
     void updateSeed();
 
     void updateDatasetPicker();
@@ -44,6 +47,7 @@ public: // Action getters
     DimensionPickerAction& getDataDimensionXAction() { return _dataDimensionActionX; };
     DimensionPickerAction& getDataDimensionYAction() { return _dataDimensionActionY; };
     ToggleAction& getRescaleInitAction() { return _rescaleInitAction; }
+    ToggleAction& getPcaInitAction() { return _pcaInitAction; }
 
 public: // Serialization
 
@@ -68,6 +72,7 @@ protected:
     DimensionPickerAction   _dataDimensionActionX;          /** Dimension of dataset to use for init X dim */
     DimensionPickerAction   _dataDimensionActionY;          /** Dimension of dataset to use for init Y dim */
     ToggleAction            _rescaleInitAction;             /** Whether to rescale the init embedding */
+    ToggleAction            _pcaInitAction;                 /** Init t-SNE with the principal components of the input data */
 
 private:
     size_t                  _numPointsInputData;            /** Number of points of the input dataset */
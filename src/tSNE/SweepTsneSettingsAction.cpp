@@ -0,0 +1,152 @@
+#include "SweepTsneSettingsAction.h"
+
+#include "TsneSettingsAction.h"
+
+#include <QStringList>
+
+#include <algorithm>
+
+using namespace mv::gui;
+
+namespace
+{
+    // Upper limit of random initializations per parameter combination
+    constexpr auto _MAX_NUM_SEEDS_ = 16;
+
+    // Upper limit of the runs of an ensemble
+    constexpr auto _MAX_ENSEMBLE_SIZE_ = 32;
+
+    /** Parse a comma separated list, invalid entries are skipped */
+    template <typename T, typename Convert>
+    std::vector<T> parseList(const QString& list, Convert convert)
+    {
+        std::vector<T> values;
+
+        for (const auto& entry : list.split(',', Qt::SkipEmptyParts))
+        {
+            bool ok = false;
+            const T value = convert(entry.trimmed(), ok);
+
+            if (ok)
+                values.push_back(value);
+        }
+
+        return values;
+    }
+}
+
+SweepTsneSettingsAction::SweepTsneSettingsAction(TsneSettingsAction& tsneSettingsAction) :
+    GroupAction(&tsneSettingsAction, "Parameter sweep", false),
+    _tsneSettingsAction(tsneSettingsAction),
+    _exaggerationFactorsAction(this, "Exaggeration factors"),
+    _exaggerationItersAction(this, "Exaggeration iterations"),
+    _numSeedsAction(this, "Seeds per setting"),
+    _startSweepAction(this, "Start sweep"),
+    _stopSweepAction(this, "Stop sweep"),
+    _ensembleSizeAction(this, "Ensemble runs"),
+    _startEnsembleAction(this, "Start ensemble")
+{
+    addAction(&_exaggerationFactorsAction);
+    addAction(&_exaggerationItersAction);
+    addAction(&_numSeedsAction);
+    addAction(&_startSweepAction);
+    addAction(&_ensembleSizeAction);
+    addAction(&_startEnsembleAction);
+    addAction(&_stopSweepAction);
+
+    _numSeedsAction.setDefaultWidgetFlags(IntegralAction::SpinBox);
+    _numSeedsAction.initialize(1, _MAX_NUM_SEEDS_, 1);
+
+    _ensembleSizeAction.setDefaultWidgetFlags(IntegralAction::SpinBox);
+    _ensembleSizeAction.initialize(2, _MAX_ENSEMBLE_SIZE_, 4);
+
+    _exaggerationFactorsAction.setPlaceHolderString("e.g. 4, 8, 12 (empty: current setting)");
+    _exaggerationItersAction.setPlaceHolderString("e.g. 100, 250 (empty: current setting)");
+
+    _exaggerationFactorsAction.setToolTip("Comma separated exaggeration factors, one embedding per factor.");
+    _exaggerationItersAction.setToolTip("Comma separated numbers of exaggeration iterations, one embedding per number.");
+    _numSeedsAction.setToolTip("Number of random initial embeddings per parameter combination, \nthe seeds count up from the random seed of the initialization settings.");
+    _startSweepAction.setToolTip("Compute the similarities once and one embedding data set per combination of the sweep settings.");
+    _ensembleSizeAction.setToolTip("Number of runs of an ensemble, the seeds count up from the random seed of the initialization settings.");
+    _startEnsembleAction.setToolTip("Embed the current settings with several seeds, re-using the similarities of the last computation. \nAll trajectories are written side by side into a single data set.");
+    _stopSweepAction.setToolTip("Stop all embeddings of the sweep or ensemble.");
+
+    _stopSweepAction.setEnabled(false);
+
+    const auto updateReadOnly = [this]() -> void {
+        const auto enable = !isReadOnly();
+
+        _exaggerationFactorsAction.setEnabled(enable);
+        _exaggerationItersAction.setEnabled(enable);
+        _numSeedsAction.setEnabled(enable);
+        _startSweepAction.setEnabled(enable);
+        _ensembleSizeAction.setEnabled(enable);
+        _startEnsembleAction.setEnabled(enable);
+    };
+
+    connect(this, &GroupAction::readOnlyChanged, this, [this, updateReadOnly](const bool& readOnly) {
+        updateReadOnly();
+    });
+
+    updateReadOnly();
+}
+
+std::vector<SweepTsneSettingsAction::Variant> SweepTsneSettingsAction::createVariants(const TsneParameters& baseParameters, int baseSeed) const
+{
+    auto exaggerationFactors = parseList<double>(_exaggerationFactorsAction.getString(), [](const QString& entry, bool& ok) { return entry.toDouble(&ok); });
+    auto exaggerationIters = parseList<int>(_exaggerationItersAction.getString(), [](const QString& entry, bool& ok) { return entry.toInt(&ok); });
+
+    if (exaggerationFactors.empty())
+        exaggerationFactors.push_back(baseParameters.getExaggerationFactor());
+
+    if (exaggerationIters.empty())
+        exaggerationIters.push_back(baseParameters.getExaggerationIter());
+
+    std::vector<Variant> variants;
+    variants.reserve(exaggerationFactors.size() * exaggerationIters.size() * _numSeedsAction.getValue());
+
+    for (const auto exaggerationFactor : exaggerationFactors)
+    {
+        for (const auto exaggerationIter : exaggerationIters)
+        {
+            for (int seedIndex = 0; seedIndex < _numSeedsAction.getValue(); seedIndex++)
+            {
+                Variant variant;
+
+                variant.parameters = baseParameters;
+                variant.parameters.setExaggerationFactor(exaggerationFactor);
+                variant.parameters.setExaggerationIter(std::max(0, exaggerationIter));
+                variant.seed = baseSeed + seedIndex;
+                variant.name = QString("TSNE Sweep (exaggeration %1, %2 iterations, seed %3)").arg(exaggerationFactor).arg(variant.parameters.getExaggerationIter()).arg(variant.seed);
+
+                variants.push_back(variant);
+            }
+        }
+    }
+
+    return variants;
+}
+
+void SweepTsneSettingsAction::fromVariantMap(const QVariantMap& variantMap)
+{
+    GroupAction::fromVariantMap(variantMap);
+
+    _exaggerationFactorsAction.fromParentVariantMap(variantMap);
+    _exaggerationItersAction.fromParentVariantMap(variantMap);
+    _numSeedsAction.fromParentVariantMap(variantMap);
+
+    if (variantMap.contains(_ensembleSizeAction.getSerializationName()))
+        _ensembleSizeAction.fromParentVariantMap(variantMap);
+}
+
+QVariantMap SweepTsneSettingsAction::toVariantMap() const
+{
+    QVariantMap variantMap = GroupAction::toVariantMap();
+
+    _exaggerationFactorsAction.insertIntoVariantMap(variantMap);
+    _exaggerationItersAction.insertIntoVariantMap(variantMap);
+    _numSeedsAction.insertIntoVariantMap(variantMap);
+    _ensembleSizeAction.insertIntoVariantMap(variantMap);
+
+    return variantMap;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "actions/GroupAction.h"
+#include "actions/IntegralAction.h"
+#include "actions/StringAction.h"
+#include "actions/TriggerAction.h"
+
+#include "TsneParameters.h"
+
+#include <QString>
+
+#include <vector>
+
+using namespace mv::gui;
+
+class TsneSettingsAction;
+
+/**
+ * Sweep TSNE setting action class
+ *
+ * Setup of a hyperparameter sweep: the combinations of the listed exaggeration factors, exaggeration
+ * iterations and seeds are embedded with one shared similarity computation.
+ * An ensemble embeds the current settings with several seeds from the similarities of the last computation.
+ */
+class SweepTsneSettingsAction : public GroupAction
+{
+public:
+
+    /** A single embedding of the sweep */
+    struct Variant
+    {
+        TsneParameters  parameters;     /** Gradient descent parameters */
+        int             seed;           /** Seed of the random initial embedding */
+        QString         name;           /** Name of the output data set */
+    };
+
+public:
+
+    /**
+     * Constructor
+     * @param tsneSettingsAction Reference to TSNE settings action
+     */
+    SweepTsneSettingsAction(TsneSettingsAction& tsneSettingsAction);
+
+    /**
+     * Combinations of the sweep settings, empty lists keep the current setting
+     * @param baseParameters Current t-SNE parameters
+     * @param baseSeed Current random seed, seeds of the variants count up from it
+     * @return Variants of the sweep
+     */
+    std::vector<Variant> createVariants(const TsneParameters& baseParameters, int baseSeed) const;
+
+public: // Action getters
+
+    TsneSettingsAction& getTsneSettingsAction() { return _tsneSettingsAction; };
+    StringAction& getExaggerationFactorsAction() { return _exaggerationFactorsAction; };
+    StringAction& getExaggerationItersAction() { return _exaggerationItersAction; };
+    IntegralAction& getNumSeedsAction() { return _numSeedsAction; };
+    TriggerAction& getStartSweepAction() { return _startSweepAction; };
+    TriggerAction& getStopSweepAction() { return _stopSweepAction; };
+    IntegralAction& getEnsembleSizeAction() { return _ensembleSizeAction; };
+    TriggerAction& getStartEnsembleAction() { return _startEnsembleAction; };
+
+public: // Serialization
+
+    /**
+     * Load plugin from variant map
+     * @param Variant map representation of the plugin
+     */
+    void fromVariantMap(const QVariantMap& variantMap) override;
+
+    /**
+     * Save plugin to variant map
+     * @return Variant map representation of the plugin
+     */
+    QVariantMap toVariantMap() const override;
+
+protected:
+    TsneSettingsAction&     _tsneSettingsAction;            /** Reference to parent tSNE settings action */
+    StringAction            _exaggerationFactorsAction;     /** Comma separated exaggeration factors */
+    StringAction            _exaggerationItersAction;       /** Comma separated numbers of exaggeration iterations */
+    IntegralAction          _numSeedsAction;                /** Number of random initializations per parameter combination */
+    TriggerAction           _startSweepAction;              /** Start the sweep */
+    TriggerAction           _stopSweepAction;               /** Stop the sweep or ensemble */
+    IntegralAction          _ensembleSizeAction;            /** Number of runs of an ensemble */
+    TriggerAction           _startEnsembleAction;           /** Start an ensemble */
+};
@@ -0,0 +1,76 @@
+#include "TrajectoryTsneSettingsAction.h"
+
+#include "TsneSettingsAction.h"
+
+using namespace mv::gui;
+
+TrajectoryTsneSettingsAction::TrajectoryTsneSettingsAction(TsneSettingsAction& tsneSettingsAction) :
+    GroupAction(&tsneSettingsAction, "Trajectory windows", false),
+    _tsneSettingsAction(tsneSettingsAction),
+    _windowSizeAction(this, "Iterations per window"),
+    _windowAction(this, "Window"),
+    _loadWindowAction(this, "Load window")
+{
+    addAction(&_windowSizeAction);
+    addAction(&_windowAction);
+    addAction(&_loadWindowAction);
+
+    _windowSizeAction.setDefaultWidgetFlags(IntegralAction::SpinBox);
+    _windowSizeAction.initialize(0, 100000, 0);
+
+    _windowAction.setDefaultWidgetFlags(OptionAction::ComboBox);
+
+    _windowSizeAction.setToolTip("Iterations of the trajectory per data set, the data set of a window is only created when it is loaded. \n0 writes the whole trajectory into the output data set.");
+    _windowAction.setToolTip("Window of iterations of the last computation");
+    _loadWindowAction.setToolTip("Write the trajectory of the selected window into its own data set");
+
+    const auto updateWindowSize = [this]() -> void {
+        _tsneSettingsAction.getTsneParameters().setTrajectoryWindow(_windowSizeAction.getValue());
+    };
+
+    const auto updateReadOnly = [this]() -> void {
+        const auto enable = !isReadOnly();
+
+        _windowSizeAction.setEnabled(enable);
+        _windowAction.setEnabled(enable && _windowAction.getNumberOfOptions() > 0);
+        _loadWindowAction.setEnabled(enable && _windowAction.getNumberOfOptions() > 0);
+    };
+
+    connect(&_windowSizeAction, &IntegralAction::valueChanged, this, [this, updateWindowSize](const std::int32_t& value) {
+        updateWindowSize();
+    });
+
+    connect(this, &GroupAction::readOnlyChanged, this, [this, updateReadOnly](const bool& readOnly) {
+        updateReadOnly();
+    });
+
+    updateWindowSize();
+    updateReadOnly();
+}
+
+void TrajectoryTsneSettingsAction::setWindows(const QStringList& windows)
+{
+    _windowAction.setOptions(windows);
+
+    if (!windows.isEmpty())
+        _windowAction.setCurrentIndex(0);
+
+    _windowAction.setEnabled(!isReadOnly() && !windows.isEmpty());
+    _loadWindowAction.setEnabled(!isReadOnly() && !windows.isEmpty());
+}
+
+void TrajectoryTsneSettingsAction::fromVariantMap(const QVariantMap& variantMap)
+{
+    GroupAction::fromVariantMap(variantMap);
+
+    _windowSizeAction.fromParentVariantMap(variantMap);
+}
+
+QVariantMap TrajectoryTsneSettingsAction::toVariantMap() const
+{
+    QVariantMap variantMap = GroupAction::toVariantMap();
+
+    _windowSizeAction.insertIntoVariantMap(variantMap);
+
+    return variantMap;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "actions/GroupAction.h"
+#include "actions/IntegralAction.h"
+#include "actions/OptionAction.h"
+#include "actions/TriggerAction.h"
+
+#include <QStringList>
+
+using namespace mv::gui;
+
+class TsneSettingsAction;
+
+/**
+ * Trajectory TSNE setting action class
+ *
+ * Publication of the recorded trajectory in windows of iterations: instead of one data set with all
+ * timesteps, every window is loaded into its own derived data set when it is requested.
+ */
+class TrajectoryTsneSettingsAction : public GroupAction
+{
+public:
+
+    /**
+     * Constructor
+     * @param tsneSettingsAction Reference to TSNE settings action
+     */
+    TrajectoryTsneSettingsAction(TsneSettingsAction& tsneSettingsAction);
+
+    /**
+     * Set the windows of the last computation
+     * @param windows Names of the windows, empty if the trajectory is not published in windows
+     */
+    void setWindows(const QStringList& windows);
+
+public: // Action getters
+
+    TsneSettingsAction& getTsneSettingsAction() { return _tsneSettingsAction; };
+    IntegralAction& getWindowSizeAction() { return _windowSizeAction; };
+    OptionAction& getWindowAction() { return _windowAction; };
+    TriggerAction& getLoadWindowAction() { return _loadWindowAction; };
+
+public: // Serialization
+
+    /**
+     * Load plugin from variant map
+     * @param Variant map representation of the plugin
+     */
+    void fromVariantMap(const QVariantMap& variantMap) override;
+
+    /**
+     * Save plugin to variant map
+     * @return Variant map representation of the plugin
+     */
+    QVariantMap toVariantMap() const override;
+
+protected:
+    TsneSettingsAction&     _tsneSettingsAction;    /** Reference to parent tSNE settings action */
+    IntegralAction          _windowSizeAction;      /** Iterations per window, 0 publishes the whole trajectory in the output data set */
+    OptionAction            _windowAction;          /** Window to load */
+    TriggerAction           _loadWindowAction;      /** Load the selected window into its data set */
+};
@@ -1,5 +1,6 @@
 #include "TsneAnalysisPlugin.h"
 
+#include "TsneBatchPipeline.h"
 #include "TsneSettingsAction.h"
 
 #include <PointData/DimensionsPickerAction.h>
@@ -14,23 +15,62 @@
 #include "hdi/data/io.h"
 #include "hdi/dimensionality_reduction/hd_joint_probability_generator.h"
 
+#include <QFileDialog>
+
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
+#include <memory>
+#include <utility>
 
 Q_PLUGIN_METADATA(IID "nl.tudelft.TsneAnalysisPlugin")
 
 using namespace mv;
 using namespace mv::util;
 
+namespace
+{
+    /** Point-major records of all runs side by side: for every point the dimensions of the first run, then of the second run etc. */
+    std::vector<float> interleaveRuns(const std::vector<std::vector<float>>& records, std::size_t numPoints, std::size_t numDimensionsPerRun)
+    {
+        const std::size_t numRuns = records.size();
+        const std::size_t numDimensions = numRuns * numDimensionsPerRun;
+
+        std::vector<float> interleaved(numPoints * numDimensions);
+
+#pragma omp parallel for schedule(static)
+        for (std::int64_t point = 0; point < static_cast<std::int64_t>(numPoints); point++)
+            for (std::size_t run = 0; run < numRuns; run++)
+                std::copy_n(records[run].data() + point * numDimensionsPerRun, numDimensionsPerRun, interleaved.data() + point * numDimensions + run * numDimensionsPerRun);
+
+        return interleaved;
+    }
+}
+
 TsneAnalysisPlugin::TsneAnalysisPlugin(const PluginFactory* factory) :
     AnalysisPlugin(factory),
     _tsneAnalysis(),
     _tsneSettingsAction(nullptr),
     _dataPreparationTask(this, "Prepare data"),
-    _probDistMatrix()
+    _sweepTask(this, "TSNE parameter sweep"),
+    _tsneSweep(),
+    _sweepDatasets(),
+    _statisticsDataset(),
+    _windowDatasets(),
+    _windowIterations(0),
+    _ensembleTask(this, "TSNE ensemble"),
+    _tsneEnsemble(),
+    _ensembleDataset(),
+    _ensembleRecords(),
+    _ensembleDimensions(),
+    _probDistMatrix(),
+    _sharedProbDistMatrix()
 {
     setObjectName("TSNE");
 
     _dataPreparationTask.setDescription("All operations prior to TSNE computation");
+    _sweepTask.setDescription("Embeddings of all variants of a parameter sweep");
+    _ensembleTask.setDescription("Embeddings of all seeds of an ensemble");
 }
 
 TsneAnalysisPlugin::~TsneAnalysisPlugin(void)
@@ -72,6 +112,8 @@ void TsneAnalysisPlugin::init()
     outputDataset->addAction(_tsneSettingsAction->getInitalEmbeddingSettingsAction());
     outputDataset->addAction(_tsneSettingsAction->getGradientDescentSettingsAction());
     outputDataset->addAction(_tsneSettingsAction->getKnnSettingsAction());
+    outputDataset->addAction(_tsneSettingsAction->getSweepSettingsAction());
+    outputDataset->addAction(_tsneSettingsAction->getTrajectorySettingsAction());
 
     auto dimensionsGroupAction = new GroupAction(this, "Dimensions", true);
 
@@ -99,12 +141,15 @@ void TsneAnalysisPlugin::init()
         _tsneSettingsAction->getInitalEmbeddingSettingsAction().setReadOnly(readonly);
         _tsneSettingsAction->getGradientDescentSettingsAction().setReadOnly(readonly);
         _tsneSettingsAction->getKnnSettingsAction().setReadOnly(readonly);
+        _tsneSettingsAction->getTrajectorySettingsAction().setReadOnly(readonly);
     };
 
     connect(&_tsneAnalysis, &TsneAnalysis::finished, this, [this, &computationAction, changeSettingsReadOnly]() {
         computationAction.getRunningAction().setChecked(false);
 
         changeSettingsReadOnly(false);
+
+        updateTrajectoryWindows();
     });
 
     connect(&_tsneAnalysis, &TsneAnalysis::aborted, this, [this, &computationAction, updateComputationAction, changeSettingsReadOnly]() {
@@ -154,11 +199,131 @@ void TsneAnalysisPlugin::init()
         events().notifyDatasetDataChanged(getOutputDataset());
     });
 
+    connect(&_tsneSettingsAction->getGeneralTsneSettingsAction().getExportProfileAction(), &TriggerAction::triggered, this, [this]() {
+        const auto* profiler = _tsneAnalysis.getProfiler();
+
+        if (!profiler)
+        {
+            qWarning() << "TsneAnalysisPlugin: nothing to export, compute an embedding first";
+            return;
+        }
+
+        const auto fileName = QFileDialog::getSaveFileName(nullptr, "Export profile", "tsne_profile.json", "Chrome trace (*.json)");
+
+        if (fileName.isEmpty())
+            return;
+
+        if (!profiler->exportChromeTrace(fileName.toStdString()))
+            qWarning() << "TsneAnalysisPlugin: could not write profile to " << fileName;
+    });
+
+    connect(&_tsneSettingsAction->getTrajectorySettingsAction().getLoadWindowAction(), &TriggerAction::triggered, this, [this]() {
+        const auto window = _tsneSettingsAction->getTrajectorySettingsAction().getWindowAction().getCurrentIndex();
+
+        if (window >= 0)
+            loadTrajectoryWindow(static_cast<std::uint32_t>(window));
+    });
+
+    connect(&_tsneAnalysis, &TsneAnalysis::trajectoryBudgetUpdate, this, [this](const QString description) {
+        _tsneSettingsAction->getGeneralTsneSettingsAction().getMemoryPolicyAction().setString(description);
+    });
+
+    connect(&_tsneAnalysis, &TsneAnalysis::statisticsUpdate, this, [this](const std::vector<float> statistics, const int numPoints, const int numStatistics) {
+        // The statistics data set is created on first use and reused by later computations
+        if (!_statisticsDataset.isValid())
+        {
+            auto derivedData = mv::data().createDerivedDataset("TSNE trajectory statistics", getInputDataset(), getInputDataset());
+            _statisticsDataset = Dataset<Points>(derivedData.get<Points>());
+        }
+
+        _statisticsDataset->setData(statistics.data(), numPoints, numStatistics);
+
+        std::vector<QString> dimensionNames;
+        for (const auto& name : TrajectoryStatistics::getNames())
+            dimensionNames.push_back(QString::fromStdString(name));
+
+        _statisticsDataset->setDimensionNames(dimensionNames);
+
+        events().notifyDatasetDataChanged(_statisticsDataset);
+    });
+
     connect(&computationAction.getRunningAction(), &ToggleAction::toggled, this, [this, &computationAction, updateComputationAction](bool toggled) {
         getInputDataset<Points>()->getDimensionsPickerAction().setEnabled(!toggled);
         updateComputationAction();
     });
 
+    auto& sweepAction = _tsneSettingsAction->getSweepSettingsAction();
+
+    const auto updateSweepActions = [this, &computationAction, &sweepAction, changeSettingsReadOnly]() {
+        const auto isSweeping = _tsneSweep.isRunning() || _tsneEnsemble.isRunning();
+
+        changeSettingsReadOnly(isSweeping);
+
+        sweepAction.getStartSweepAction().setEnabled(!isSweeping && !computationAction.getRunningAction().isChecked());
+        sweepAction.getStartEnsembleAction().setEnabled(!isSweeping && !computationAction.getRunningAction().isChecked());
+        sweepAction.getStopSweepAction().setEnabled(isSweeping);
+        computationAction.getStartComputationAction().setEnabled(!isSweeping);
+    };
+
+    connect(&sweepAction.getStartSweepAction(), &TriggerAction::triggered, this, [this, updateSweepActions]() {
+        if (_tsneSettingsAction->getComputationAction().getRunningAction().isChecked())
+            return;
+
+        qDebug() << "TsneAnalysisPlugin: starting parameter sweep...";
+        startSweep();
+        updateSweepActions();
+    });
+
+    connect(&sweepAction.getStartEnsembleAction(), &TriggerAction::triggered, this, [this, updateSweepActions]() {
+        if (_tsneSettingsAction->getComputationAction().getRunningAction().isChecked())
+            return;
+
+        qDebug() << "TsneAnalysisPlugin: starting ensemble...";
+        startEnsemble();
+        updateSweepActions();
+    });
+
+    connect(&sweepAction.getStopSweepAction(), &TriggerAction::triggered, this, [this]() {
+        _tsneSweep.stopComputation();
+        _tsneEnsemble.stopComputation();
+    });
+
+    connect(&_tsneSweep, &TsneSweep::finished, this, updateSweepActions);
+    connect(&_tsneSweep, &TsneSweep::aborted, this, updateSweepActions);
+
+    connect(&_tsneEnsemble, &TsneSweep::finished, this, [this, updateSweepActions]() {
+        updateEnsembleDataset();
+        updateSweepActions();
+    });
+
+    connect(&_tsneEnsemble, &TsneSweep::aborted, this, updateSweepActions);
+
+    connect(&_tsneEnsemble, &TsneSweep::embeddingUpdate, this, [this](std::size_t run, const std::vector<float> embeddingRecords, const int numPoints, const int numDismensions) {
+        if (run >= _ensembleRecords.size())
+            return;
+
+        _ensembleRecords[run] = embeddingRecords;
+        _ensembleDimensions[run] = numDismensions;
+
+        // The live view follows the cadence of the first run, the final trajectories are written once all runs finished
+        if (run == 0)
+            updateEnsembleDataset();
+    });
+
+    connect(&_tsneSweep, &TsneSweep::embeddingUpdate, this, [this](std::size_t variant, const std::vector<float> embeddingRecords, const int numPoints, const int numDismensions) {
+        if (variant >= _sweepDatasets.size() || !_sweepDatasets[variant].isValid())
+            return;
+
+        auto& sweepDataset = _sweepDatasets[variant];
+
+        sweepDataset->setData(embeddingRecords.data(), numPoints, numDismensions);
+
+        events().notifyDatasetDataChanged(sweepDataset);
+    });
+
+    _tsneSweep.setTask(&_sweepTask);
+    _tsneEnsemble.setTask(&_ensembleTask);
+
     updateComputationAction();
 
     auto& datasetTask = outputDataset->getTask();
@@ -189,25 +354,18 @@ void TsneAnalysisPlugin::startComputation()
 
     auto inputPoints = getInputDataset<Points>();
 
-    // Create list of data from the enabled dimensions
-    std::vector<float> data;
-    std::vector<unsigned int> indices;
-
     // Extract the enabled dimensions from the data
     std::vector<bool> enabledDimensions = getInputDataset<Points>()->getDimensionsPickerAction().getEnabledDimensions();
 
-    const auto numEnabledDimensions = count_if(enabledDimensions.begin(), enabledDimensions.end(), [](bool b) { return b; });
-
     _tsneSettingsAction->getGeneralTsneSettingsAction().getNumberOfComputatedIterationsAction().reset();
 
-    const auto numPoints = inputPoints->isFull() ? inputPoints->getNumPoints() : inputPoints->indices.size();
-    data.resize(numPoints * numEnabledDimensions);
+    // Borrows the data of the input if possible, otherwise gathers the enabled dimensions
+    TsneInputData input = TsneInputData::fromPoints(inputPoints, enabledDimensions);
 
-    for (int i = 0; i < inputPoints->getNumDimensions(); i++)
-        if (enabledDimensions[i])
-            indices.push_back(i);
+    const auto numPoints = input.getNumPoints();
 
-    inputPoints->populateDataForDimensions<std::vector<float>, std::vector<unsigned int>>(data, indices);
+    // The similarities are recomputed, ensemble runs keep their own reference
+    _sharedProbDistMatrix.reset();
 
     _tsneSettingsAction->getComputationAction().getRunningAction().setChecked(true);
 
@@ -217,15 +375,204 @@ void TsneAnalysisPlugin::startComputation()
 
     _dataPreparationTask.setFinished();
     //qDebug() << "TSNE Parameters: " << _tsneSettingsAction->getTsneParameters().getPresetEmbedding(); // 0
-    _tsneAnalysis.startComputation(_tsneSettingsAction->getTsneParameters(), _tsneSettingsAction->getKnnParameters(), std::move(data), numEnabledDimensions, &initEmbedding);
+    _tsneAnalysis.startComputation(_tsneSettingsAction->getTsneParameters(), _tsneSettingsAction->getKnnParameters(), std::move(input), &initEmbedding);
+}
+
+void TsneAnalysisPlugin::updateTrajectoryWindows()
+{
+    const auto* trajectory = _tsneAnalysis.getTrajectory();
+
+    _windowIterations = _tsneSettingsAction->getTsneParameters().getTrajectoryWindow();
+
+    QStringList windows;
+
+    if (trajectory && !trajectory->empty() && _windowIterations > 0)
+    {
+        const auto endIteration = trajectory->getIterations().back() + 1;
+
+        for (int beginIteration = 0; beginIteration < endIteration; beginIteration += _windowIterations)
+            windows << QString("Iterations %1 - %2").arg(beginIteration).arg(std::min(beginIteration + _windowIterations, endIteration) - 1);
+    }
+
+    _tsneSettingsAction->getTrajectorySettingsAction().setWindows(windows);
+
+    // Windows that consumers loaded before follow the new trajectory
+    for (const auto& [window, windowDataset] : _windowDatasets)
+        if (window < static_cast<std::uint32_t>(windows.size()) && windowDataset.isValid())
+            loadTrajectoryWindow(window);
+}
+
+void TsneAnalysisPlugin::loadTrajectoryWindow(std::uint32_t window)
+{
+    const auto* trajectory = _tsneAnalysis.getTrajectory();
+
+    if (!trajectory || trajectory->empty() || _windowIterations <= 0 || _tsneSettingsAction->getComputationAction().getRunningAction().isChecked())
+        return;
+
+    const int beginIteration = static_cast<int>(window) * _windowIterations;
+    const auto [firstTimestep, lastTimestep] = trajectory->findTimesteps(beginIteration, beginIteration + _windowIterations);
+
+    if (firstTimestep == lastTimestep)
+    {
+        qWarning() << "TsneAnalysisPlugin::loadTrajectoryWindow: no embeddings were saved in window " << window;
+        return;
+    }
+
+    const auto name = QString("TSNE trajectory %1 - %2").arg(trajectory->getIterations()[firstTimestep]).arg(trajectory->getIterations()[lastTimestep - 1]);
+
+    auto& windowDataset = _windowDatasets[window];
+
+    if (!windowDataset.isValid())
+    {
+        auto derivedData = mv::data().createDerivedDataset(name, getInputDataset(), getInputDataset());
+        windowDataset = Dataset<Points>(derivedData.get<Points>());
+    }
+    else
+        windowDataset->setText(name);
+
+    const auto records = trajectory->toPointMajor(firstTimestep, lastTimestep);
+
+    windowDataset->setData(records.data(), trajectory->getNumPoints(), (lastTimestep - firstTimestep) * trajectory->getNumDimensions());
+
+    events().notifyDatasetDataChanged(windowDataset);
+}
+
+void TsneAnalysisPlugin::startSweep()
+{
+    auto& initSettings = _tsneSettingsAction->getInitalEmbeddingSettingsAction();
+
+    const auto variants = _tsneSettingsAction->getSweepSettingsAction().createVariants(_tsneSettingsAction->getTsneParameters(), initSettings.getRandomSeedAction().getValue());
+
+    auto inputPoints = getInputDataset<Points>();
+
+    std::vector<bool> enabledDimensions = inputPoints->getDimensionsPickerAction().getEnabledDimensions();
+
+    // Borrows the data of the input if possible, otherwise gathers the enabled dimensions
+    TsneInputData input = TsneInputData::fromPoints(inputPoints, enabledDimensions);
+
+    const auto numPoints = input.getNumPoints();
+
+    std::vector<TsneParameters> parameters;
+    std::vector<std::vector<float>> initEmbeddings;
+
+    parameters.reserve(variants.size());
+    initEmbeddings.reserve(variants.size());
+
+    for (std::size_t variantIndex = 0; variantIndex < variants.size(); variantIndex++)
+    {
+        const auto& variant = variants[variantIndex];
+
+        // Data sets of a previous sweep are reused
+        if (variantIndex >= _sweepDatasets.size() || !_sweepDatasets[variantIndex].isValid())
+        {
+            auto derivedData = mv::data().createDerivedDataset(variant.name, getInputDataset(), getInputDataset());
+            auto sweepDataset = Dataset<Points>(derivedData.get<Points>());
+
+            std::vector<float> initialData(2ull * numPoints);
+            sweepDataset->setData(initialData.data(), numPoints, 2);
+            events().notifyDatasetDataChanged(sweepDataset);
+
+            if (variantIndex < _sweepDatasets.size())
+                _sweepDatasets[variantIndex] = sweepDataset;
+            else
+                _sweepDatasets.push_back(sweepDataset);
+        }
+        else
+            _sweepDatasets[variantIndex]->setText(variant.name);
+
+        parameters.push_back(variant.parameters);
+        initEmbeddings.push_back(initSettings.getInitEmbedding(numPoints, variant.parameters.getNumDimensionsOutput(), variant.seed));
+    }
+
+    _tsneSweep.startComputation(parameters, _tsneSettingsAction->getKnnParameters(), std::move(input), std::move(initEmbeddings));
+}
+
+void TsneAnalysisPlugin::startEnsemble()
+{
+    // The runs share the similarities of the last computation read-only, they are moved into shared ownership instead of copied
+    std::shared_ptr<const ProbDistMatrix> probDist;
+
+    if (_tsneAnalysis.canContinue())
+        probDist = _tsneAnalysis.shareProbabilityDistribution();
+
+    if (!probDist && _probDistMatrix.size() > 0)
+    {
+        _sharedProbDistMatrix = std::make_shared<const ProbDistMatrix>(std::move(_probDistMatrix));
+        _probDistMatrix = ProbDistMatrix();
+    }
+
+    if (!probDist)
+        probDist = _sharedProbDistMatrix;
+
+    if (!probDist)
+        probDist = _tsneSweep.getProbabilityDistribution();
+
+    if (!probDist || probDist->size() == 0)
+    {
+        qWarning() << "TsneAnalysisPlugin::startEnsemble: cannot start an ensemble - start computation first";
+        return;
+    }
+
+    const auto numPoints = probDist->size();
+    const auto ensembleSize = static_cast<std::size_t>(_tsneSettingsAction->getSweepSettingsAction().getEnsembleSizeAction().getValue());
+
+    auto& initSettings = _tsneSettingsAction->getInitalEmbeddingSettingsAction();
+
+    const auto& parameters = _tsneSettingsAction->getTsneParameters();
+    const auto baseSeed = initSettings.getRandomSeedAction().getValue();
+
+    std::vector<std::vector<float>> initEmbeddings;
+    initEmbeddings.reserve(ensembleSize);
+
+    for (std::size_t run = 0; run < ensembleSize; run++)
+        initEmbeddings.push_back(initSettings.getInitEmbedding(numPoints, parameters.getNumDimensionsOutput(), baseSeed + static_cast<int>(run)));
+
+    if (!_ensembleDataset.isValid())
+    {
+        auto derivedData = mv::data().createDerivedDataset("TSNE Ensemble", getInputDataset(), getInputDataset());
+        _ensembleDataset = Dataset<Points>(derivedData.get<Points>());
+    }
+
+    _ensembleDataset->setText(QString("TSNE Ensemble (%1 runs, seeds %2 to %3)").arg(ensembleSize).arg(baseSeed).arg(baseSeed + static_cast<int>(ensembleSize) - 1));
+
+    _ensembleRecords.assign(ensembleSize, {});
+    _ensembleDimensions.assign(ensembleSize, 0);
+
+    _tsneEnsemble.startComputation(std::vector<TsneParameters>(ensembleSize, parameters), std::move(probDist), std::move(initEmbeddings));
+}
+
+void TsneAnalysisPlugin::updateEnsembleDataset()
+{
+    if (!_ensembleDataset.isValid() || _ensembleRecords.empty() || _ensembleDimensions.front() <= 0)
+        return;
+
+    // Runs are only written together when their records have the same layout, e.g. all current positions or all final trajectories
+    const auto numDimensionsPerRun = _ensembleDimensions.front();
+
+    for (std::size_t run = 0; run < _ensembleRecords.size(); run++)
+        if (_ensembleDimensions[run] != numDimensionsPerRun || _ensembleRecords[run].size() != _ensembleRecords.front().size())
+            return;
+
+    const auto numPoints = _ensembleRecords.front().size() / numDimensionsPerRun;
+
+    const auto interleaved = interleaveRuns(_ensembleRecords, numPoints, numDimensionsPerRun);
+
+    _ensembleDataset->setData(interleaved.data(), numPoints, static_cast<unsigned int>(_ensembleRecords.size() * numDimensionsPerRun));
+
+    events().notifyDatasetDataChanged(_ensembleDataset);
 }
 
 void TsneAnalysisPlugin::reinitializeComputation()
 {
     if (_tsneAnalysis.canContinue())
-        _probDistMatrix = std::move(*_tsneAnalysis.getProbabilityDistribution().value());
+    {
+        if (const auto shared = _tsneAnalysis.getSharedProbabilityDistribution())
+            _sharedProbDistMatrix = shared;
+        else
+            _probDistMatrix = std::move(*_tsneAnalysis.getProbabilityDistribution().value());
+    }
     
-    if(_probDistMatrix.size() == 0)
+    if(_probDistMatrix.size() == 0 && !_sharedProbDistMatrix)
     {
         qDebug() << "TsneAnalysisPlugin::reinitializeComputation: cannot reinitialize embedding - start computation first";
         return;
@@ -240,7 +587,10 @@ void TsneAnalysisPlugin::reinitializeComputation()
     int embeddingDim = _tsneSettingsAction->getTsneParameters().getNumDimensionsOutput();
     auto initEmbedding = initSettings.getInitEmbedding(numPoints, embeddingDim);
 
-    _tsneAnalysis.startComputation(_tsneSettingsAction->getTsneParameters(), std::move(_probDistMatrix), numPoints, &initEmbedding);
+    if (_sharedProbDistMatrix)
+        _tsneAnalysis.startComputation(_tsneSettingsAction->getTsneParameters(), _sharedProbDistMatrix, &initEmbedding);
+    else
+        _tsneAnalysis.startComputation(_tsneSettingsAction->getTsneParameters(), std::move(_probDistMatrix), numPoints, &initEmbedding);
 }
 
 void TsneAnalysisPlugin::continueComputation()
@@ -253,7 +603,7 @@ void TsneAnalysisPlugin::continueComputation()
 
     if (_tsneAnalysis.canContinue())
         _tsneAnalysis.continueComputation(_tsneSettingsAction->getTsneParameters().getNumIterations());
-    else if (_probDistMatrix.size() > 0)
+    else if (_probDistMatrix.size() > 0 || _sharedProbDistMatrix)
     {
         auto currentEmbedding = getOutputDataset<Points>();
 
@@ -267,7 +617,12 @@ void TsneAnalysisPlugin::continueComputation()
             currentEmbedding->populateDataForDimensions<std::vector<float>, std::vector<unsigned int>>(currentEmbeddingPositions, { 0 });
         }
 
-        _tsneAnalysis.startComputation(_tsneSettingsAction->getTsneParameters(), std::move(_probDistMatrix), currentEmbedding->getNumPoints(), &currentEmbeddingPositions, _tsneSettingsAction->getGeneralTsneSettingsAction().getNumberOfComputatedIterationsAction().getValue());
+        const auto previousIterations = _tsneSettingsAction->getGeneralTsneSettingsAction().getNumberOfComputatedIterationsAction().getValue();
+
+        if (_sharedProbDistMatrix)
+            _tsneAnalysis.startComputation(_tsneSettingsAction->getTsneParameters(), _sharedProbDistMatrix, &currentEmbeddingPositions, previousIterations);
+        else
+            _tsneAnalysis.startComputation(_tsneSettingsAction->getTsneParameters(), std::move(_probDistMatrix), currentEmbedding->getNumPoints(), &currentEmbeddingPositions, previousIterations);
     }
     else
     {
@@ -319,7 +674,9 @@ QVariantMap TsneAnalysisPlugin::toVariantMap() const
 
     _tsneSettingsAction->insertIntoVariantMap(variantMap);
 
-    const auto probabilityDistribution = _tsneAnalysis.getProbabilityDistribution();
+    // Shared with ensemble runs, the distribution of the analysis itself is empty then
+    const auto sharedProbabilityDistribution = _tsneAnalysis.getSharedProbabilityDistribution();
+    const auto probabilityDistribution = sharedProbabilityDistribution ? std::optional<const ProbDistMatrix*>(sharedProbabilityDistribution.get()) : _tsneAnalysis.getProbabilityDistribution();
 
     if (_tsneSettingsAction->getGeneralTsneSettingsAction().getSaveProbDistAction().isChecked() && probabilityDistribution != std::nullopt)
     {
@@ -373,6 +730,20 @@ PluginTriggerActions TsneAnalysisPluginFactory::getPluginTriggerActions(const mv
             pluginTriggerActions << pluginTriggerAction;
         }
 
+        if (datasets.count() >= 2) {
+            auto pluginTriggerAction = new PluginTriggerAction(const_cast<TsneAnalysisPluginFactory*>(this), this, "Batch/TSNE", "Perform TSNE analysis on each selected dataset in one pipeline", getIcon(), [this, getPluginInstance, datasets](PluginTriggerAction& pluginTriggerAction) -> void {
+                // Deletes itself once all datasets are embedded
+                auto batchPipeline = new TsneBatchPipeline();
+
+                for (const auto& dataset : datasets)
+                    batchPipeline->addPlugin(getPluginInstance(dataset));
+
+                batchPipeline->start();
+            });
+
+            pluginTriggerActions << pluginTriggerAction;
+        }
+
         if (datasets.count() >= 2) {
             auto pluginTriggerAction = new PluginTriggerAction(const_cast<TsneAnalysisPluginFactory*>(this), this, "Group/TSNE", "Group datasets and perform TSNE analysis on it", getIcon(), [this, getPluginInstance, datasets](PluginTriggerAction& pluginTriggerAction) -> void {
                 getPluginInstance(mv::data().groupDatasets(datasets));
@@ -4,6 +4,11 @@
 #include <Task.h>
 
 #include "TsneAnalysis.h"
+#include "TsneSweep.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
 
 using namespace mv::plugin;
 using namespace mv::gui;
@@ -19,11 +24,20 @@ public:
 
     void init() override;
 
+    TsneAnalysis& getTsneAnalysis() { return _tsneAnalysis; }
+    TsneSettingsAction& getTsneSettingsAction() { return *_tsneSettingsAction; }
+
     void startComputation();
     void reinitializeComputation();
     void continueComputation();
     void stopComputation();
 
+    /** Embed all variants of the sweep settings with one shared similarity computation, one output data set per variant */
+    void startSweep();
+
+    /** Embed the current settings with several seeds from the similarities of the last computation, all trajectories in one data set */
+    void startEnsemble();
+
 public: // Serialization
 
     /**
@@ -42,10 +56,32 @@ private:
     TsneAnalysis                        _tsneAnalysis;          /** TSNE analysis */
     TsneSettingsAction*                 _tsneSettingsAction;    /** TSNE settings action */
     mv::Task                            _dataPreparationTask;   /** Task for reporting data preparation progress */
+    mv::Task                            _sweepTask;             /** Task for reporting parameter sweep progress */
+    TsneSweep                           _tsneSweep;             /** Parameter sweep, shares the similarities between its embeddings */
+    std::vector<mv::Dataset<Points>>    _sweepDatasets;         /** Output data sets of the sweep variants */
     //std::vector<float>                  _embeddingRecord;       /** Embeddings over iterated timesteps */
+    mv::Dataset<Points>                 _statisticsDataset;     /** Per-point trajectory statistics of the last computation */
+    std::map<std::uint32_t, mv::Dataset<Points>>    _windowDatasets;    /** Loaded trajectory windows by window index */
+    int                                 _windowIterations;      /** Iterations per trajectory window of the last computation */
+
+    mv::Task                            _ensembleTask;          /** Task for reporting ensemble progress */
+    TsneSweep                           _tsneEnsemble;          /** Ensemble of seeds, shares the similarities of the last computation */
+    mv::Dataset<Points>                 _ensembleDataset;       /** Trajectories of all ensemble runs side by side */
+    std::vector<std::vector<float>>     _ensembleRecords;       /** Latest records of every ensemble run */
+    std::vector<int>                    _ensembleDimensions;    /** Number of dimensions of the latest records of every ensemble run */
+
+private:
+    void updateEnsembleDataset();
+
+    /** List the trajectory windows of the last computation and refresh the loaded ones */
+    void updateTrajectoryWindows();
+
+    /** Write a window of the trajectory of the last computation into its data set, created on first use */
+    void loadTrajectoryWindow(std::uint32_t window);
 
 private:
     ProbDistMatrix                      _probDistMatrix;        /** Probability distribution matrix used for serialization */
+    std::shared_ptr<const ProbDistMatrix> _sharedProbDistMatrix; /** Probability distribution shared with ensemble runs, used instead of _probDistMatrix if set */
 };
 
 class TsneAnalysisPluginFactory : public AnalysisPluginFactory
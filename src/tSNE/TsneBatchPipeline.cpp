@@ -0,0 +1,152 @@
+#include "TsneBatchPipeline.h"
+
+#include "TsneAnalysisPlugin.h"
+#include "TsneSettingsAction.h"
+
+#include <QDebug>
+
+using namespace mv;
+
+namespace
+{
+    // Data sets started ahead of the oldest running one, each holds its input and similarities until its gradient descent is done
+    constexpr std::uint32_t _MAX_LOOKAHEAD_ = 2;
+}
+
+TsneBatchPipeline::TsneBatchPipeline(QObject* parent) :
+    QObject(parent),
+    _entries(),
+    _next(0),
+    _numActive(0),
+    _stopped(false),
+    _finished(false),
+    _task(this, "TSNE batch")
+{
+    _task.setDescription("Embed all data sets of the batch");
+    _task.setSubtaskNamePrefix("Embed data set");
+
+    connect(&_task, &Task::requestAbort, this, [this]() -> void { stop(); });
+}
+
+void TsneBatchPipeline::addPlugin(TsneAnalysisPlugin* plugin)
+{
+    Entry entry;
+    entry.plugin = plugin;
+
+    _entries.push_back(entry);
+}
+
+void TsneBatchPipeline::start()
+{
+    qDebug() << "TsneBatchPipeline: embedding " << _entries.size() << " data sets with a lookahead of " << _MAX_LOOKAHEAD_;
+
+    _task.setRunning();
+    _task.setSubtasks(static_cast<std::uint32_t>(_entries.size()));
+
+    startNext();
+}
+
+void TsneBatchPipeline::stop()
+{
+    _stopped = true;
+    _next = _entries.size();
+
+    // Not through the stop action, which ignores triggers while it is disabled
+    for (auto& entry : _entries)
+        if (entry.active && entry.plugin)
+            entry.plugin->stopComputation();
+
+    if (_numActive == 0)
+        finish();
+}
+
+void TsneBatchPipeline::startNext()
+{
+    while (!_stopped && _next < _entries.size() && _numActive < 1 + _MAX_LOOKAHEAD_)
+        launch(_next++);
+
+    if (_numActive == 0 && _next >= _entries.size())
+        finish();
+}
+
+void TsneBatchPipeline::launch(std::size_t index)
+{
+    auto& entry = _entries[index];
+
+    _task.setSubtaskStarted(static_cast<std::uint32_t>(index));
+
+    // The plugin might have been removed in the meantime
+    if (!entry.plugin)
+    {
+        _task.setSubtaskFinished(static_cast<std::uint32_t>(index));
+        return;
+    }
+
+    auto& tsneAnalysis = entry.plugin->getTsneAnalysis();
+
+    entry.finishedConnection = connect(&tsneAnalysis, &TsneAnalysis::finished, this, [this, index]() -> void { onDone(index); });
+    entry.abortedConnection = connect(&tsneAnalysis, &TsneAnalysis::aborted, this, [this, index]() -> void { onDone(index); });
+    entry.destroyedConnection = connect(entry.plugin.data(), &QObject::destroyed, this, [this, index]() -> void { onDone(index); });
+
+    // Earlier data sets are started first when all embedding workers are busy
+    tsneAnalysis.setPriority(-static_cast<int>(index));
+
+    entry.active = true;
+    _numActive++;
+
+    auto& computationAction = entry.plugin->getTsneSettingsAction().getComputationAction();
+
+    bool started = false;
+    const auto startedConnection = connect(&tsneAnalysis, &TsneAnalysis::started, this, [&started]() -> void { started = true; });
+
+    // Same path as the start button, such that the plugin updates its settings and tasks
+    computationAction.getStartComputationAction().trigger();
+
+    disconnect(startedConnection);
+
+    // A disabled start action ignores the trigger: a computation that already runs is waited for, otherwise the data set is skipped
+    if (!started && !computationAction.getRunningAction().isChecked())
+    {
+        qWarning() << "TsneBatchPipeline: could not start the computation of data set " << index + 1 << ", skipping it";
+        onDone(index);
+    }
+}
+
+void TsneBatchPipeline::onDone(std::size_t index)
+{
+    auto& entry = _entries[index];
+
+    if (!entry.active)
+        return;
+
+    disconnect(entry.finishedConnection);
+    disconnect(entry.abortedConnection);
+    disconnect(entry.destroyedConnection);
+
+    entry.active = false;
+    _numActive--;
+
+    if (entry.plugin)
+        entry.plugin->getTsneAnalysis().setPriority(0);
+
+    _task.setSubtaskFinished(static_cast<std::uint32_t>(index));
+
+    startNext();
+}
+
+void TsneBatchPipeline::finish()
+{
+    if (_finished)
+        return;
+
+    _finished = true;
+
+    qDebug() << "TsneBatchPipeline: " << (_stopped ? "stopped" : "finished") << " batch of " << _entries.size() << " data sets";
+
+    if (_stopped)
+        _task.setAborted();
+    else
+        _task.setFinished();
+
+    deleteLater();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Task.h>
+
+#include <QMetaObject>
+#include <QObject>
+#include <QPointer>
+
+#include <cstdint>
+#include <vector>
+
+class TsneAnalysisPlugin;
+
+/**
+ * TsneBatchPipeline
+ *
+ * Embeds the input data sets of several t-SNE plugin instances one after another from a single trigger.
+ * Besides the data set in gradient descent, at most a fixed number of following data sets is started ahead,
+ * such that their data preparation and similarity computation overlap with the gradient descent while the
+ * number of inputs and probability distributions in memory stays bounded. Earlier data sets have a higher
+ * scheduling priority, and a single task reports the progress of the whole batch.
+ *
+ * The pipeline deletes itself when all data sets are done.
+ */
+class TsneBatchPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    TsneBatchPipeline(QObject* parent = nullptr);
+
+    /** Append a plugin instance, the pipeline starts its computation when it is due */
+    void addPlugin(TsneAnalysisPlugin* plugin);
+
+    /** Start the batch */
+    void start();
+
+    /** Stop the running computations and skip the remaining data sets */
+    void stop();
+
+private:
+    void startNext();
+    void launch(std::size_t index);
+    void onDone(std::size_t index);
+    void finish();
+
+private:
+    struct Entry
+    {
+        QPointer<TsneAnalysisPlugin>        plugin;             /** Plugin instance of the data set */
+        QMetaObject::Connection             finishedConnection; /** Connection to the end of its computation */
+        QMetaObject::Connection             abortedConnection;  /** Connection to the abort of its computation */
+        QMetaObject::Connection             destroyedConnection;/** Connection to the removal of the plugin, which ends its computation without a signal */
+        bool                                active = false;     /** Whether its computation is running */
+    };
+
+private:
+    std::vector<Entry>  _entries;       /** Data sets of the batch in order */
+    std::size_t         _next;          /** Index of the next data set to start */
+    std::uint32_t       _numActive;     /** Number of started, unfinished data sets */
+    bool                _stopped;       /** Whether the batch was stopped */
+    bool                _finished;      /** Whether the batch is done */
+    mv::Task            _task;          /** Progress of the batch, one subtask per data set */
+};
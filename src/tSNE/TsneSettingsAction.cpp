@@ -11,12 +11,16 @@ TsneSettingsAction::TsneSettingsAction(QObject* parent, size_t numPointsInputDat
     _generalTsneSettingsAction(*this),
     _initTsneSettingsAction(*this, numPointsInputData),
     _gradientDescentSettingsAction(this, _tsneParameters),
-    _knnSettingsAction(this, _knnParameters)
+    _knnSettingsAction(this, _knnParameters),
+    _sweepSettingsAction(*this),
+    _trajectorySettingsAction(*this)
 {
     const auto updateReadOnly = [this]() -> void {
         _generalTsneSettingsAction.setReadOnly(isReadOnly());
         _gradientDescentSettingsAction.setReadOnly(isReadOnly());
         _knnSettingsAction.setReadOnly(isReadOnly());
+        _sweepSettingsAction.setReadOnly(isReadOnly());
+        _trajectorySettingsAction.setReadOnly(isReadOnly());
     };
 
     connect(this, &GroupAction::readOnlyChanged, this, [this, updateReadOnly](const bool& readOnly) {
@@ -47,6 +51,12 @@ void TsneSettingsAction::fromVariantMap(const QVariantMap& variantMap)
     _initTsneSettingsAction.fromParentVariantMap(variantMap);
     _gradientDescentSettingsAction.fromVariantMap(variantMap["Gradient Descent Settings"].toMap());
     _knnSettingsAction.fromVariantMap(variantMap["Knn Settings"].toMap());
+
+    if (variantMap.contains(_sweepSettingsAction.getSerializationName()))
+        _sweepSettingsAction.fromParentVariantMap(variantMap);
+
+    if (variantMap.contains(_trajectorySettingsAction.getSerializationName()))
+        _trajectorySettingsAction.fromParentVariantMap(variantMap);
 }
 
 QVariantMap TsneSettingsAction::toVariantMap() const
@@ -57,6 +67,8 @@ QVariantMap TsneSettingsAction::toVariantMap() const
     _initTsneSettingsAction.insertIntoVariantMap(variantMap);
     _gradientDescentSettingsAction.insertIntoVariantMap(variantMap);
     _knnSettingsAction.insertIntoVariantMap(variantMap);
+    _sweepSettingsAction.insertIntoVariantMap(variantMap);
+    _trajectorySettingsAction.insertIntoVariantMap(variantMap);
 
     return variantMap;
 }
@@ -5,6 +5,8 @@
 #include "InitTsneSettings.h"
 #include "KnnParameters.h"
 #include "KnnSettingsAction.h"
+#include "SweepTsneSettingsAction.h"
+#include "TrajectoryTsneSettingsAction.h"
 #include "TsneParameters.h"
 
 using namespace mv::gui;
@@ -46,6 +48,8 @@ public: // Action getters
     InitTsneSettings& getInitalEmbeddingSettingsAction() { return _initTsneSettingsAction; }
     GradientDescentSettingsAction& getGradientDescentSettingsAction() { return _gradientDescentSettingsAction; }
     KnnSettingsAction& getKnnSettingsAction() { return _knnSettingsAction; }
+    SweepTsneSettingsAction& getSweepSettingsAction() { return _sweepSettingsAction; }
+    TrajectoryTsneSettingsAction& getTrajectorySettingsAction() { return _trajectorySettingsAction; }
     TsneComputationAction& getComputationAction() { return _generalTsneSettingsAction.getComputationAction(); }
 
 public: // Serialization
@@ -71,5 +75,7 @@ private:
     InitTsneSettings                _initTsneSettingsAction;            /** Inital embedding settings action */
     GradientDescentSettingsAction   _gradientDescentSettingsAction;     /** Gradient descent settings action */
     KnnSettingsAction               _knnSettingsAction;                 /** knn settings action */
+    SweepTsneSettingsAction         _sweepSettingsAction;               /** Hyperparameter sweep settings action */
+    TrajectoryTsneSettingsAction    _trajectorySettingsAction;          /** Trajectory windows settings action */
 
 };